@@ -23,36 +23,77 @@ allowed for the position that gave the maximum alpha to be easily selected.
 
 At the beginning of each iteration of the alpha-beta search, there are two checks to be made before
 carrying on. The first is determing whether the current node is terminal, meaning either the
-opponent has three in a row, or the square is filled, with these situations indicating a loss and a
-draw respectively. A seperate function was used to evaluate this, which simply uses brute force to
-check every row, column and diagonal of all squares. The second thing to note is when the depth
-equals zero, with this stopping the search from going any deeper and instead returning the heuristic
-value of this node. A very tough choice I had to make was deciding what heuristic function I would
-use. I decided to use a variant of the regular tic-tac-toe heuristic described in the tutorial,
-being 3*X2 + X1 - (3*O2 + O1). This value is calculated for each square of the grid using a seperate
-function, with the final heuristic for the node being the sum of all such values. Finally, when
-testing my agent against different opponents I had to decide what search depth was most appropriate
-to use. Whilst lower depths made calculations quicker, higher depths provided better solutions. I
-ended up selecting a depth of 10 for my search, and whilst I would have preferred to increase this
-further, doing so made the program run very close to being outside of the provided time limit,
-and I decided it wasn't worth the risk of losing because of a timeout.
+opponent has three in a row on the square they just played in, or the square we have been sent to
+is filled, with these situations indicating a loss and a draw respectively. To keep this cheap, the
+board is stored as a bitboard, with one 9-bit mask per player for each square, so that the list of
+legal moves is just a few mask operations, and both checks are made once when a move is played
+rather than by scanning every square at every node. The second thing to note is when the depth
+equals zero, with this stopping the search from going any deeper and instead returning the
+heuristic value of this node. A very tough choice I had to make was deciding what heuristic
+function I would use. I decided to use a variant of the regular tic-tac-toe heuristic described in
+the tutorial, being 3*X2 + X1 - (3*O2 + O1). This value is calculated for each square of the grid,
+with the final heuristic for the node being the sum of all such values. Since a single square only
+has 3^9 possible states, this value, along with whether the square is won or full, is worked out
+ahead of time by a generator program and stored in tables. A move only changes one square, so
+making or undoing it looks up the new value of that square and updates a running total, which means
+neither check costs more as the search goes deeper. Finally, when testing my agent against
+different opponents I had to decide what search depth was most appropriate to use. Whilst lower
+depths made calculations quicker, higher depths provided better solutions. A fixed depth of 10 ran
+very close to the time limit early in the game, yet finished in a few milliseconds near the end, so
+instead the agent uses iterative deepening, searching to depth 1, then 2, and so on. It keeps its
+own copy of the server's clock, allowing itself the time for the current move plus a share of any
+time saved on earlier moves, and if a search runs past this it is abandoned and the move from the
+deepest completed search is played. Optionally the agent also thinks on its opponent's time: once
+its move has been sent, a background thread searches the position the opponent now faces, which
+covers every reply they could make on that square, while the main thread waits for the server. As
+soon as the reply arrives the background search is stopped, and the search for our own move finds
+much of the work it needs already in the transposition table. The replies to second_move and
+third_move never change, so they are worked out once, much more deeply than there is time for in a
+game, by a separate program, and read from a book that the agent maps into memory at the start.
 */
 
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
 #include <sys/time.h>
+#include <pthread.h>
 
 #include "common.h"
 #include "agent.h"
-#include "game.h"
-
-#define MAX_MOVE 81
-
-int board[10][10];
-int move[MAX_MOVE+1];
-int player;
-int m;
+#include "engine.h"
+#include "book.h"
+
+// All of the agent's state is kept in one engine, which these settings are
+// copied into once it has been made.
+engine *agent_engine = NULL;
+
+// When the server plays several games at once over the connection, each game
+// has an engine of its own, taken from this table when the game starts and
+// given back when it is over.
+typedef struct {
+  int id;          // the server's number for the game, or 0 if the engine is free
+  engine *e;
+  int busy;        // TRUE while a worker is finding a move with it
+} agent_game;
+
+agent_game *agent_games = NULL;
+int num_agent_games = 0;
+int max_agent_games = 0;   // most games to play at once, set with -g
+pthread_mutex_t agent_games_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t  agent_games_idle = PTHREAD_COND_INITIALIZER;
+
+int hash_megabytes = 32;   // memory for an engine's search tables, set with -m
+int num_threads = 1;       // search threads, set with -j
+int endgame_empties = 50;  // solve exactly with this many empty cells, set with -e
+int proof_search = FALSE;  // look for forced wins, set with -f
+int verbose = FALSE;       // report each search on stderr, set with -v
+int ponder = FALSE;        // search on the opponent's time, set with -P
+char *book_path = "book.bin"; // opening book written by mkbook, set with -b
+char *stats_path = NULL;   // where to write search statistics, set with -s
+FILE *stats_file = NULL;
+int seconds_initially = 30;
+int seconds_per_move  =  2;
 
 /*********************************************************//*
    Print usage information and exit
@@ -62,6 +103,18 @@ void usage( char argv0[] )
   printf("Usage: %s\n",argv0);
   printf("       [-p port]\n"); // tcp port
   printf("       [-h host]\n"); // tcp host
+  // number of seconds allocated initially, and per move
+  printf("       [-t initial permove]\n");
+  printf("       [-m megabytes]\n"); // memory for the search tables
+  printf("       [-j threads]\n");  // number of search threads
+  printf("       [-e empties]\n");  // solve exactly with this many empty cells
+  printf("       [-f]\n");           // look for forced wins with proof-number search
+  printf("       [-P]\n");           // think on the opponent's time
+  printf("       [-b book]\n");      // opening book, book.bin by default
+  printf("       [-s file|-]\n");    // search statistics, as JSON lines or on stderr
+  printf("       [-g games]\n");    // most games to play at once, if the server offers
+  printf("       [-w workers]\n");  // threads to play them with
+  printf("       [-v]\n");           // report each search on stderr
   exit(1);
 }
 
@@ -86,12 +139,118 @@ void agent_parse_args( int argc, char *argv[] )
       host = argv[i+1];
       i += 2;
     }
+    else if( strcmp( argv[i], "-t" ) == 0 ) {
+      if( i+2 >= argc ) {
+        usage( argv[0] );
+      }
+      seconds_initially = atoi(argv[i+1]);
+      seconds_per_move  = atoi(argv[i+2]);
+      if(   seconds_initially <= 0
+         || seconds_per_move  <  0 ) {
+        usage( argv[0] );
+      }
+      i += 3;
+    }
+    else if( strcmp( argv[i], "-m" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      hash_megabytes = atoi(argv[i+1]);
+      if( hash_megabytes <= 0 ) {
+        usage( argv[0] );
+      }
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-f" ) == 0 ) {
+      proof_search = TRUE;
+      i++;
+    }
+    else if( strcmp( argv[i], "-e" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      endgame_empties = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-j" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      num_threads = atoi(argv[i+1]);
+      if( num_threads < 1 || num_threads > MAX_THREADS ) {
+        usage( argv[0] );
+      }
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-s" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      stats_path = argv[i+1];
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-g" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      max_agent_games = atoi(argv[i+1]);
+      if( max_agent_games < 1 ) {
+        usage( argv[0] );
+      }
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-w" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      workers = atoi(argv[i+1]);
+      if( workers < 1 ) {
+        usage( argv[0] );
+      }
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-b" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      book_path = argv[i+1];
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-P" ) == 0 ) {
+      ponder = TRUE;
+      i++;
+    }
+    else if( strcmp( argv[i], "-v" ) == 0 ) {
+      verbose = TRUE;
+      i++;
+    }
     else {
       usage( argv[0] );
     }
   }
 }
 
+/*********************************************************//*
+   Make an engine with the settings given on the command line
+*/
+engine *agent_new_engine( int megabytes )
+{
+  engine *e = engine_new( megabytes );
+  if( e == NULL ) {
+    fprintf( stderr, "out of memory\n" );
+    exit(1);
+  }
+  e->num_threads = num_threads;
+  e->endgame_empties = endgame_empties;
+  e->proof_search = proof_search;
+  e->verbose = verbose;
+  e->ponder = ponder;
+  e->seconds_initially = seconds_initially;
+  e->seconds_per_move = seconds_per_move;
+  e->stats_file = stats_file;
+  return( e );
+}
+
 /*********************************************************//*
    Called at the beginning of a series of games
 */
@@ -102,6 +261,20 @@ void agent_init()
   // generate a new random seed each time
   gettimeofday( &tp, NULL );
   srandom(( unsigned int )( tp.tv_usec ));
+
+  if( stats_path != NULL && strcmp( stats_path, "-" ) == 0 ) {
+    stats_file = stderr;
+  }
+  else if( stats_path != NULL ) {
+    stats_file = fopen( stats_path, "a" );
+    if( stats_file == NULL ) {
+      perror( stats_path );
+    }
+  }
+  agent_engine = agent_new_engine( hash_megabytes );
+  if( book_open( book_path ) && verbose ) {
+    fprintf( stderr, "using opening book %s\n", book_path );
+  }
 }
 
 /*********************************************************//*
@@ -109,10 +282,7 @@ void agent_init()
 */
 void agent_start( int this_player )
 {
-  reset_board( board );
-  m = 0;
-  move[m] = 0;
-  player = this_player;
+  engine_start( agent_engine, this_player );
 }
 
 /*********************************************************//*
@@ -120,23 +290,7 @@ void agent_start( int this_player )
 */
 int agent_second_move( int board_num, int prev_move )
 {
-  // Based on the information passed in through the arguments, we update the move list
-  // and the positions played on the board.
-  int this_move;
-  move[0] = board_num;
-  move[1] = prev_move;
-  board[board_num][prev_move] = !player;
-  m = 2;
-
-  // We then use the function setup_search to begin the alpha-beta search, with the final
-  // returned move from this search being assigned to this_move.
-  this_move = setup_search(prev_move);
-
-  // Finally, based on the move selected above, we update the move list and place this
-  // selection on the board.
-  move[m] = this_move;
-  board[prev_move][this_move] = player;
-  return( this_move );
+  return( engine_second_move( agent_engine, board_num, prev_move ));
 }
 
 /*********************************************************//*
@@ -148,25 +302,7 @@ int agent_third_move(
                      int prev_move
                     )
 {
-  // Based on the information passed in through the arguments, we update the move list
-  // and the positions played on the board.
-  int this_move;
-  move[0] = board_num;
-  move[1] = first_move;
-  move[2] = prev_move;
-  board[board_num][first_move] =  player;
-  board[first_move][prev_move] = !player;
-  m=3;
-
-  // We then use the function setup_search to begin the alpha-beta search, with the final
-  // returned move from this search being assigned to this_move.
-  this_move = setup_search(prev_move);
-
-  // Finally, based on the move selected above, we update the move list and place this
-  // selection on the board.
-  move[m] = this_move;
-  board[move[m-1]][this_move] = player;
-  return( this_move );
+  return( engine_third_move( agent_engine, board_num, first_move, prev_move ));
 }
 
 /*********************************************************//*
@@ -174,468 +310,213 @@ int agent_third_move(
 */
 int agent_next_move( int prev_move )
 {
-  // Based on the information passed in through the arguments, we update the move list
-  // and the positions played on the board.
-  int this_move;
-  m++;
-  move[m] = prev_move;
-  board[move[m-1]][move[m]] = !player;
-  m++;
-
-  // We then use the function setup_search to begin the alpha-beta search, with the final
-  // returned move from this search being assigned to this_move.
-  this_move = setup_search(prev_move);
-
-  // Finally, based on the move selected above, we update the move list and place this
-  // selection on the board.
-  move[m] = this_move;
-  board[move[m-1]][this_move] = player;
-  return( this_move );
+  return( engine_next_move( agent_engine, prev_move ));
 }
 
 /*********************************************************//*
-   This is the first iteration of the alpha-beta search, returning the position to play in
+   Receive last move and mark it on the board
 */
-int setup_search( int current_board )
+void agent_last_move( int prev_move )
 {
+  engine_last_move( agent_engine, prev_move );
+}
 
-  // This is the depth in which our alpha-beta search will traverse down to.
-  // Higher depths will provide better results yet will take more time to compute.
-  int depth = 10;
-
-  // When we start our alpha-beta search, we set alpha = -infinity and beta = infinity.
-  // Since the maximum heuristic value for any node is 100, using -200 and 200 will suffice.
-  int alpha = -200;
-  int beta = 200;
-
-  // The first iteration of our alpha-beta search is done here so we can determine the actual move
-  // we want to make, as our alpha_beta_search function only returns the value of alpha not the move
-  // which provided this value.
-  int this_move = -1;
-
-  // We loop through for all possible positions on the current board
-  int i;
-  for (i = 1; i <= 9; ++i) {
-
-    // We first check if this position is already filled on the board.
-    // If it is, playing here would be an illegal move, so we ignore this position and move on.
-    if (board[current_board][i] == EMPTY) {
-
-      // For the chosen position, we assign this move on the board.
-      board[current_board][i] = player;
-
-      // We now call our alpha_beta_search function to recursively check all children nodes,
-      // either until its terminal or the depth is reached. The depth is decreased by 1 and
-      // the new board will be the position we are playing on the current board, being i.
-      // Note since we are using the negamax variant, our value of alpha is -beta
-      // and our value of beta is -alpha. Also, it is considered from the perspective
-      // of the opponent, so we pass in !player as the current player.
-      int search_result = -alpha_beta_search(i, depth - 1, -beta, -alpha, !player);
-
-      // After attaining our results from the search, we can undo our move on this position.
-      board[current_board][i] = EMPTY;
-
-      // Here we are taking the max of our current alpha and the return value
-      // of the alpha beta search, assigning this as alpha.
-      if (search_result > alpha) {
-        alpha = search_result;
-
-        // If the alpha beta search returned a larger alpha than our previous alpha,
-        // we not only update alpha but also update the move to be chosen.
-        this_move = i;
-      }
-    }
-  }
-
-  // We return the chosen move after the search is completed.
-  return this_move;
+/*********************************************************//*
+   Take the time left on our clock from the server
+*/
+void agent_clock( int msec_left, int msec_per_move )
+{
+  engine_clock( agent_engine, msec_left, msec_per_move );
 }
 
 /*********************************************************//*
-   Negamax formulation of alpha-beta search
+   Start thinking on the opponent's time, after our move has been sent
 */
-int alpha_beta_search( int current_board, int depth, int alpha, int beta, int current_player )
+void agent_ponder()
 {
+  engine_ponder( agent_engine );
+}
 
-  // Before we continue with the search, we first check if the current node is terminal.
-  // This involves checking all columns, rows and diagonals to see if the opponent
-  // got 3 in a row in the previous move, in which case we return -100, or if there
-  // are any squares that are filled so that a move can no longer be made, where 0 is returned.
-  int k;
-  for (k = 1; k <= 9; ++k) {
+/*********************************************************//*
+   Called after each game
+*/
+void agent_gameover(
+                    int result,// WIN, LOSS or DRAW
+                    int cause  // TRIPLE, ILLEGAL_MOVE, TIMEOUT or FULL_BOARD
+                   )
+{
+  engine_gameover( agent_engine, result, cause );
+}
 
-    // For each board, we call the evaluate_terminal function and store its returned value.
-    int is_terminal_node = evaluate_terminal(k, current_player);
+/*********************************************************//*
+   Called if the server offers to play up to max_games games at
+   once, returning how many we will play
+*/
+int agent_multi( int max_games )
+{
+  int k, megabytes;
 
-    // If we did find a terminal node, we return this value and stop searching this child node.
-    if ((is_terminal_node == -100) | (is_terminal_node == 0)) {
-      return is_terminal_node;
-    }
+  if( max_agent_games > 0 && max_games > max_agent_games ) {
+    max_games = max_agent_games;
   }
-
-  // If the depth of the search equals 0, we don't want to search any deeper, and instead calculate
-  // a heuristic value for this node. We use the function 3*X2 + X1 - (3*O2 + O1) for each board,
-  // with the sum of all such values being our total heuristic value that we return.
-  if (depth == 0) {
-    int heuristic = 0;
-    int j;
-    for (j = 1; j <= 9; ++j) {
-
-      // For all boards on the grid, we sum together their heuristic values which we calculate
-      // using evaluate_heuristic.
-      heuristic += evaluate_heuristic(j, current_player);
-    }
-    return heuristic;
+  // The games share out as much memory again as the one engine has, which
+  // is kept in case the server plays a game at a time after all, and the
+  // opponent's time is spent on the other games rather than pondering.
+  megabytes = hash_megabytes / max_games;
+  if( megabytes < 1 ) {
+    megabytes = 1;
   }
-
-  // Now for each child of the current node, we can begin our alpha-beta search
-  // using the negamax formulation.
-  int i;
-  for (i = 1; i <= 9; ++i) {
-
-    // We first check if this position is already filled on the board.
-    // If it is, playing here would be an illegal move, so we ignore this position and move on.
-    if (board[current_board][i] == EMPTY) {
-
-      // For the chosen position, we assign this move on the board.
-      board[current_board][i] = current_player;
-
-      // This is where we recursively call alpha_beta_search. We store the negative of the final
-      // result in a variable, which we will later compare against our current alpha.
-      // Like before, the new board is the same as the position we have chosen,
-      // the depth is decreased by 1, alpha is -beta and beta is -alpha, and
-      // we are playing from the perspective of the opponent, so player is !current_player.
-      int search_result = -alpha_beta_search(i, depth - 1, -beta, -alpha, !current_player);
-
-      // After attaining our results from the search, we can undo our move on this position.
-      board[current_board][i] = EMPTY;
-
-      // Here we are taking the max of our current alpha and the return value
-      // of the alpha beta search, assigning this as alpha.
-      if (search_result > alpha) {
-        alpha = search_result;
-      }
-
-      // This is the pruning stage of the alpha-beta search, and is what allows the depth
-      // to be much greater than what would be possible using regular minimax.
-      // All we do is compare alpha and beta, and if alpha is greater or equal,
-      // we can prune this section of the tree and return alpha.
-      if (alpha >= beta) {
-          return alpha;
-      }
-    }
+  agent_games = calloc( max_games, sizeof( agent_game ));
+  if( agent_games == NULL ) {
+    return( 0 );
   }
-
-  // Finally we return alpha after searching all child nodes.
-  return alpha;
-
+  for( k = 0; k < max_games; k++ ) {
+    agent_games[k].e = agent_new_engine( megabytes );
+    agent_games[k].e->ponder = FALSE;
+  }
+  num_agent_games = max_games;
+  return( max_games );
 }
 
 /*********************************************************//*
-   Evaluating if the current node is terminal
+   Find the engine playing game id, and mark it busy until it is
+   given back, or return NULL if the game is already over
 */
-int evaluate_terminal( int current_board, int current_player )
+engine *agent_game_take( int id, long long asked )
 {
+  engine *e = NULL;
+  int k;
 
-  // Firstly we want to evaluate if the current board has 3 in a row for the opponent,
-  // making it a winning position.
-
-  // We first check all the columns of the board. If an opponent has 3 in one column
-  // we return -100 as the heuristic value.
-  int i;
-  for (i = 1; i <= 3; ++i) {
-    if ((board[current_board][i] == !current_player)
-    && (board[current_board][i + 3] == !current_player)
-    && (board[current_board][i + 6] == !current_player)) {
-      return -100;
-    }
-  }
-
-  // We then check all the rows of the board. If an opponent has 3 in one row
-  // we return -100 as the heuristic value.
-  int j;
-  for (j = 1; j <= 9; j = j + 3) {
-    if ((board[current_board][j] == !current_player)
-    && (board[current_board][j + 1] == !current_player)
-    && (board[current_board][j + 2] == !current_player)) {
-      return -100;
+  pthread_mutex_lock( &agent_games_lock );
+  for( k = 0; k < num_agent_games; k++ ) {
+    if( agent_games[k].id == id ) {
+      agent_games[k].busy = TRUE;
+      e = agent_games[k].e;
+      e->move_asked = asked;
     }
   }
+  pthread_mutex_unlock( &agent_games_lock );
+  return( e );
+}
 
-  // Finally we check both the diagonals of the board. If an opponent has 3 in one diagonal
-  // we return -100 as the heuristic value.
-  if ((board[current_board][1] == !current_player)
-  && (board[current_board][5] == !current_player)
-  && (board[current_board][9] == !current_player)) {
-      return -100;
-  } else if ((board[current_board][3] == !current_player)
-  && (board[current_board][5] == !current_player)
-  && (board[current_board][7] == !current_player)) {
-      return -100;
-  }
+/*********************************************************//*
+   Give back an engine once its move has been found
+*/
+void agent_game_give( engine *e )
+{
+  int k;
 
-  // Our other check for a terminal node is a tie, meaning the board is filled.
-  // This is tested by looking for an empty space, and if we find one we can exit
-  // as it mustn't be full.
-  int p;
-  for (p = 1; p <= 9; ++p) {
-    if (board[current_board][p] == EMPTY) {
-      return -1;
+  pthread_mutex_lock( &agent_games_lock );
+  for( k = 0; k < num_agent_games; k++ ) {
+    if( agent_games[k].e == e ) {
+      agent_games[k].busy = FALSE;
     }
   }
-
-  // If an empty position wasn't found on the board, it must be filled so we return 0
-  // for a tie.
-  return 0;
-
+  pthread_cond_broadcast( &agent_games_idle );
+  pthread_mutex_unlock( &agent_games_lock );
 }
 
 /*********************************************************//*
-   If the depth of the alpha-beta search is 0, evaluate the heuristic value of this node
+   The callbacks for a game played alongside others, the same
+   as those above but with the engine chosen by game id. A move
+   asked for in a game that is over by the time a worker gets to
+   it comes back as 0, and the worker sends no reply for it.
 */
-int evaluate_heuristic( int current_board, int current_player )
+void agent_game_start( int id, int this_player )
 {
+  int k;
 
-  // When calculating the heuristic value of the node, we need to determine what
-  // combination of pieces are in each row, column and diagonal of the board.
-  // To make things easier, we will assume the current player is X, and the opponent
-  // is O.
-
-  // If there are 2 X's and no O's in a row, we increment the variable x2.
-  // If there is 1 X and no O's, we increment the variable x1.
-  // Similarly, we use the same logic for the variables o2 and o1.
-  int x2 = 0;
-  int x1 = 0;
-  int o2 = 0;
-  int o1 = 0;
-
-  // We first check all the columns of the board. To make the various if statements
-  // easier to follow, a comment is placed beside them to indicate what this
-  // column would look like on the board.
-  int i;
-  for (i = 1; i <= 3; ++i) {
-    if (board[current_board][i] == current_player) { // X
-      if (board[current_board][i + 3] == current_player) { // XX
-        if (board[current_board][i + 6] == EMPTY) { // XX_
-          x2++;
-        }
-    } else if (board[current_board][i + 3] == EMPTY) { // X_
-        if (board[current_board][i + 6] == current_player) { // X_X
-            x2++;
-        } else if (board[current_board][i + 6] == EMPTY) { // X__
-            x1++;
-        }
-      }
-    } else if (board[current_board][i] == !current_player) { // O
-      if (board[current_board][i + 3] == !current_player) { // OO
-        if (board[current_board][i + 6] == EMPTY) { // OO_
-          o2++;
-        }
-      } else if (board[current_board][i + 3] == EMPTY) { // O_
-        if (board[current_board][i + 6] == !current_player) { // O_O
-          o2++;
-        } else if (board[current_board][i + 6] == EMPTY) { // O__
-          o1++;
-        }
-      }
-    } else { // _
-      if (board[current_board][i + 3] == current_player) { // _X
-        if (board[current_board][i + 6] == current_player) { // _XX
-          x2++;
-        } else if (board[current_board][i + 6] == EMPTY) { // _X_
-          x1++;
-        }
-      } else if (board[current_board][i + 3] == !current_player) { // _O
-        if (board[current_board][i + 6] == !current_player) { // _OO
-          o2++;
-        } else if (board[current_board][i + 6] == EMPTY) { // _O_
-          o1++;
-        }
-      } else { // __
-        if (board[current_board][i + 6] == current_player) { // __X
-          x1++;
-        } else if (board[current_board][i + 6] == !current_player) { // __O
-          o1++;
-        }
-      }
+  pthread_mutex_lock( &agent_games_lock );
+  for( k = 0; k < num_agent_games; k++ ) {
+    if( agent_games[k].id == 0 && !agent_games[k].busy ) {
+      break;
     }
   }
-
-  // We then check all the rows of the board. To make the various if statements
-  // easier to follow, a comment is placed beside them to indicate what this
-  // row would look like on the board.
-  int j;
-  for (j = 1; j <= 9; j = j + 3) {
-      if (board[current_board][j] == current_player) { // X
-        if (board[current_board][j + 1] == current_player) { // XX
-          if (board[current_board][j + 2] == EMPTY) { // XX_
-            x2++;
-          }
-        } else if (board[current_board][j + 1] == EMPTY) { // X_
-          if (board[current_board][j + 2] == current_player) { // X_X
-              x2++;
-          } else if (board[current_board][j + 2] == EMPTY) { // X__
-              x1++;
-          }
-        }
-      } else if (board[current_board][j] == !current_player) { // O
-        if (board[current_board][j + 1] == !current_player) { // OO
-          if (board[current_board][j + 2] == EMPTY) { // OO_
-            o2++;
-          }
-        } else if (board[current_board][j + 1] == EMPTY) { // O_
-          if (board[current_board][j + 2] == !current_player) { // O_O
-            o2++;
-          } else if (board[current_board][j + 2] == EMPTY) { // O__
-            o1++;
-          }
-        }
-      } else { // _
-        if (board[current_board][j + 1] == current_player) { // _X
-          if (board[current_board][j + 2] == current_player) { // _XX
-            x2++;
-          } else if (board[current_board][j + 2] == EMPTY) { // _X_
-            x1++;
-          }
-        } else if (board[current_board][j + 1] == !current_player) { // _O
-          if (board[current_board][j + 2] == !current_player) { // _OO
-            o2++;
-          } else if (board[current_board][j + 2] == EMPTY) { // _O_
-            o1++;
-          }
-        } else { // __
-          if (board[current_board][j + 2] == current_player) { // __X
-            x1++;
-          } else if (board[current_board][j + 2] == !current_player) { // __O
-            o1++;
-          }
-        }
-      }
+  if( k == num_agent_games ) {
+    fprintf( stderr, "more games at once than agreed\n" );
+    exit(1);
   }
+  agent_games[k].id = id;
+  pthread_mutex_unlock( &agent_games_lock );
+  engine_start( agent_games[k].e, this_player );
+}
 
-  // Finally, we check both the diagonals of the board. To make the various if statements
-  // easier to follow, a comment is placed beside them to indicate what this
-  // diagonal would look like on the board.
-  if (board[current_board][1] == current_player) { // X
-    if (board[current_board][5] == current_player) { // XX
-        if (board[current_board][9] == EMPTY) { // XX_
-            x2++;
-        }
-    } else if (board[current_board][5] == EMPTY) { // X_
-        if (board[current_board][9] == current_player) { // X_X
-            x2++;
-        } else if (board[current_board][9] == EMPTY) { // X__
-            x1++;
-        }
-    }
-  } else if (board[current_board][1] == !current_player) { // O
-    if (board[current_board][5] == !current_player) { // OO
-        if (board[current_board][9] == EMPTY) { // OO_
-            o2++;
-        }
-    } else if (board[current_board][5] == EMPTY) { // O_
-        if (board[current_board][9] == !current_player) { // O_O
-            o2++;
-        } else if (board[current_board][9] == EMPTY) { // O__
-            o1++;
-        }
-    }
-  } else { // _
-    if (board[current_board][5] == current_player) { // _X
-      if (board[current_board][9] == current_player) { // _XX
-        x2++;
-      } else if (board[current_board][9] == EMPTY) { // _X_
-        x1++;
-      }
-    } else if (board[current_board][5] == !current_player) { // _O
-      if (board[current_board][9] == !current_player) { // _OO
-        o2++;
-      } else if (board[current_board][9] == EMPTY) { // _O_
-        o1++;
-      }
-    } else { // __
-      if (board[current_board][9] == current_player) { // __X
-        x1++;
-      } else if (board[current_board][9] == !current_player) { // __O
-        o1++;
-      }
-    }
+int agent_game_second_move( int id, long long asked, int board_num, int prev_move )
+{
+  engine *e = agent_game_take( id, asked );
+  int this_move = 0;
+  if( e != NULL ) {
+    this_move = engine_second_move( e, board_num, prev_move );
+    agent_game_give( e );
   }
+  return( this_move );
+}
 
-  // This is the second diagonal to be calculated.
-  if (board[current_board][3] == current_player) { // X
-    if (board[current_board][5] == current_player) { // XX
-        if (board[current_board][7] == EMPTY) { // XX_
-            x2++;
-        }
-    } else if (board[current_board][5] == EMPTY) { // X_
-        if (board[current_board][7] == current_player) { // X_X
-            x2++;
-        } else if (board[current_board][7] == EMPTY) { // X__
-            x1++;
-        }
-    }
-  } else if (board[current_board][3] == !current_player) { // O
-    if (board[current_board][5] == !current_player) { // OO
-        if (board[current_board][7] == EMPTY) { // OO_
-            o2++;
-        }
-    } else if (board[current_board][5] == EMPTY) { // O_
-        if (board[current_board][7] == !current_player) { // O_O
-            o2++;
-        } else if (board[current_board][7] == EMPTY) { // O__
-            o1++;
-        }
-    }
-  } else { // _
-    if (board[current_board][5] == current_player) { // _X
-      if (board[current_board][7] == current_player) { // _XX
-        x2++;
-      } else if (board[current_board][7] == EMPTY) { // _X_
-        x1++;
-      }
-    } else if (board[current_board][5] == !current_player) { // _O
-      if (board[current_board][7] == !current_player) { // _OO
-        o2++;
-      } else if (board[current_board][7] == EMPTY) { // _O_
-        o1++;
-      }
-    } else { // __
-      if (board[current_board][7] == current_player) { // __X
-        x1++;
-      } else if (board[current_board][7] == !current_player) { // __O
-        o1++;
-      }
-    }
+int agent_game_third_move( int id, long long asked, int board_num, int first_move, int prev_move )
+{
+  engine *e = agent_game_take( id, asked );
+  int this_move = 0;
+  if( e != NULL ) {
+    this_move = engine_third_move( e, board_num, first_move, prev_move );
+    agent_game_give( e );
   }
+  return( this_move );
+}
 
-  // After all values of x2, x1, o2 and o1 have been calculated for the current board,
-  // we simply insert them into the heuristic function 3*X2 + X1 - (3*O2 + O1).
-  // This value is then returned and added to the sum of all other heuristic values.
-  int heuristic_function = 3*x2 + x1 - (3*o2 + o1);
+int agent_game_next_move( int id, long long asked, int prev_move )
+{
+  engine *e = agent_game_take( id, asked );
+  int this_move = 0;
+  if( e != NULL ) {
+    this_move = engine_next_move( e, prev_move );
+    agent_game_give( e );
+  }
+  return( this_move );
+}
 
-  return heuristic_function;
+void agent_game_last_move( int id, int prev_move )
+{
+  engine *e = agent_game_take( id, 0 );
+  if( e != NULL ) {
+    engine_last_move( e, prev_move );
+    agent_game_give( e );
+  }
 }
 
-/*********************************************************//*
-   Receive last move and mark it on the board
-*/
-void agent_last_move( int prev_move )
+void agent_game_clock( int id, int msec_left, int msec_per_move )
 {
-  m++;
-  move[m] = prev_move;
-  board[move[m-1]][move[m]] = !player;
+  engine *e = agent_game_take( id, 0 );
+  if( e != NULL ) {
+    engine_clock( e, msec_left, msec_per_move );
+    agent_game_give( e );
+  }
 }
 
-/*********************************************************//*
-   Called after each game
-*/
-void agent_gameover(
-                    int result,// WIN, LOSS or DRAW
-                    int cause  // TRIPLE, ILLEGAL_MOVE, TIMEOUT or FULL_BOARD
-                   )
+void agent_game_over( int id, int result, int cause )
 {
-  // nothing to do here
+  struct timespec ts;
+  int k;
+
+  // If we ran out of time the game may be over while a worker is still
+  // searching it, in which case it is told to stop and we wait for it.
+  pthread_mutex_lock( &agent_games_lock );
+  for( k = 0; k < num_agent_games; k++ ) {
+    if( agent_games[k].id == id ) {
+      while( agent_games[k].busy ) {
+        set_search_stop( agent_games[k].e, TRUE );
+        clock_gettime( CLOCK_REALTIME, &ts );
+        ts.tv_nsec += 10000000;
+        if( ts.tv_nsec >= 1000000000 ) {
+          ts.tv_sec++;
+          ts.tv_nsec -= 1000000000;
+        }
+        pthread_cond_timedwait( &agent_games_idle, &agent_games_lock, &ts );
+      }
+      agent_games[k].id = 0;
+      engine_gameover( agent_games[k].e, result, cause );
+    }
+  }
+  pthread_mutex_unlock( &agent_games_lock );
 }
 
 /*********************************************************//*
@@ -643,5 +524,16 @@ void agent_gameover(
 */
 void agent_cleanup()
 {
-  // nothing to do here
+  int k;
+  for( k = 0; k < num_agent_games; k++ ) {
+    engine_free( agent_games[k].e );
+  }
+  free( agent_games );
+  num_agent_games = 0;
+  engine_free( agent_engine );
+  agent_engine = NULL;
+  book_close();
+  if( stats_file != NULL && stats_file != stderr ) {
+    fclose( stats_file );
+  }
 }
@@ -6,6 +6,7 @@
  */
 extern int   port;
 extern char *host;
+extern int   workers;  // threads to play games with when several are played at once
 
  //  parse command-line arguments
 void agent_parse_args( int argc, char *argv[] );
@@ -24,20 +25,36 @@ int  agent_next_move( int prev_move );
 
 void agent_last_move( int prev_move );
 
+ //  called before a move request if the server tells us the time left on
+ //  our clock, counting the time added for this move, and the time it adds
+void agent_clock( int msec_left, int msec_per_move );
+
+ //  called once our move has been sent, to think on the opponent's time
+void agent_ponder();
+
  //  called at the end of each game
 void agent_gameover( int result, int cause );
 
- //  called at the end of the series of games
-void agent_cleanup();
+ //  called if the server offers to play up to max_games games at once,
+ //  returning how many the agent will play, or 0 to refuse
+int  agent_multi( int max_games );
+
+ //  the same for game id, when several are played at once; the _move
+ //  functions are called on worker threads, for different games at once,
+ //  and asked is when the request arrived, from clock_usec()
+void agent_game_start( int id, int this_player );
 
-// Used for the first iteration of the alpha-beta search, returns the position to play in
-int setup_search(int current_board);
+int  agent_game_second_move( int id, long long asked, int board_num, int prev_move );
 
-// Negamax formulation of alpha-beta search
-int alpha_beta_search(int current_board, int depth, int alpha, int beta, int current_player);
+int  agent_game_third_move( int id, long long asked, int board_num, int first_move, int prev_move );
 
-// Evaluates if the current node is terminal
-int evaluate_terminal(int current_board, int current_player);
+int  agent_game_next_move( int id, long long asked, int prev_move );
 
-// Evaluates the heuristic value of a node
-int evaluate_heuristic(int current_board, int current_player);
+void agent_game_last_move( int id, int prev_move );
+
+void agent_game_clock( int id, int msec_left, int msec_per_move );
+
+void agent_game_over( int id, int result, int cause );
+
+ //  called at the end of the series of games
+void agent_cleanup();
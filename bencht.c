@@ -0,0 +1,391 @@
+/*********************************************************
+ *  bencht.c
+ *  Nine-Board Tic-Tac-Toe Microbenchmarks
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Times the kernels the search spends its time in, over games
+ *  played out at random from each position in a file, and then
+ *  a fixed-depth alpha-beta search of each position. Every kernel
+ *  reports its speed and a checksum of the values it returned,
+ *  so when two builds are compared a change in speed shows up in
+ *  the first and a change in behaviour in the second. The games
+ *  are the same every run, as random() is given a fixed seed.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "game.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "search.h"
+
+#define MAX_GAMES    100
+#define MAX_SAMPLES  ( MAX_GAMES * 82 )
+
+typedef struct {
+  int move[82];   // as in servt, move[0] is the sub-board of the first move
+  int first;      // moves up to here came from the file, the rest at random
+  int last;       // index of the last move
+} bench_game;
+
+bench_game games[MAX_GAMES];
+int num_games = 0;
+
+// every position reached in the games, with the sub-board and player to move
+position sample_pos[MAX_SAMPLES];
+int sample_cells[MAX_SAMPLES][10][10];
+int sample_board[MAX_SAMPLES];
+int sample_player[MAX_SAMPLES];
+int num_samples = 0;
+
+engine *bench_engine;
+search_thread bench_thread;
+
+/*********************************************************//*
+   Print usage information and exit
+*/
+void usage( char argv0[] )
+{
+  printf("Usage: %s\n",argv0);
+  printf("       [-d depth]\n");     // depth of the alpha-beta search
+  printf("       [-r repeat]\n");    // times each kernel is run on each sample
+  printf("       [-m megabytes]\n"); // memory for the search tables
+  printf("       [positions]\n");    // file of positions, one per line
+  exit(1);
+}
+
+/*********************************************************//*
+   Fold a value into a checksum
+*/
+static inline uint64_t mix( uint64_t checksum, int value )
+{
+  return(( checksum ^ ( uint32_t )value ) * 0x100000001B3ULL );
+}
+
+/*********************************************************//*
+   Print the result of one kernel
+*/
+void report( char *name, long ops, long long usec, uint64_t checksum )
+{
+  printf("%-20s ops %10ld  %8.2f ns/op  checksum %016llx\n",
+         name, ops, ops ? usec * 1000.0 / ops : 0.0,
+         ( unsigned long long )checksum );
+}
+
+/*********************************************************//*
+   Read a game from a line of the positions file and play it
+   out to the end with random moves, recording each position
+   on the way, or return FALSE if the line holds no position
+*/
+int play_game( char *line, bench_game *g )
+{
+  int board[10][10];
+  position pos;
+  int m, p=0, status=STILL_PLAYING;
+  char *s;
+
+  if( line[0] < '1' || line[0] > '9' ) {
+    return( FALSE );
+  }
+  g->move[0] = line[0] - '0';
+  m = 0;
+  for( s = line+1; *s >= '1' && *s <= '9' && m < 81; s++ ) {
+    g->move[++m] = *s - '0';
+  }
+  g->first = m;
+
+  pos_reset( &pos );
+  reset_board( board );
+  for( m = 1; m <= g->first; m++ ) {
+    status = make_move( p, m, g->move, board );
+    pos_make( &pos, p, g->move[m-1], g->move[m] );
+    if( status != STILL_PLAYING ) {
+      return( FALSE );
+    }
+    p = !p;
+  }
+
+  // The position before each move is a sample, and so is the one
+  // the game ends in, so the kernels also see won and drawn games.
+  while( num_samples < MAX_SAMPLES ) {
+    sample_pos[num_samples] = pos;
+    memcpy( sample_cells[num_samples], board, sizeof( board ));
+    sample_board[num_samples] = g->move[m-1];
+    sample_player[num_samples] = p;
+    num_samples++;
+    if( status != STILL_PLAYING ) {
+      break;
+    }
+    int empty = pos_empty( &pos, g->move[m-1] );
+    int c;
+    do {
+      c = 1 + random() % 9;
+    } while( !( empty & CELL_BIT(c) ));
+    g->move[m] = c;
+    status = make_move( p, m, g->move, board );
+    pos_make( &pos, p, g->move[m-1], c );
+    p = !p;
+    m++;
+  }
+  g->last = m-1;
+  return( TRUE );
+}
+
+/*********************************************************//*
+   Time evaluate_heuristic, for both players in every sample
+*/
+void bench_heuristic( int repeat )
+{
+  search_thread *t = &bench_thread;
+  uint64_t checksum = 0;
+  long long usec = 0, start;
+  int i, r, sum;
+
+  for( i = 0; i < num_samples; i++ ) {
+    t->pos = sample_pos[i];
+    sum = 0;
+    start = clock_usec();
+    for( r = 0; r < repeat; r++ ) {
+      sum += evaluate_heuristic( t, r & 1 );
+    }
+    usec += clock_usec() - start;
+    checksum = mix( checksum, evaluate_heuristic( t, 0 ));
+    checksum = mix( checksum, sum );
+  }
+  report( "evaluate_heuristic", ( long )num_samples * repeat, usec, checksum );
+}
+
+/*********************************************************//*
+   Time evaluate_terminal, for both players in every sample
+*/
+void bench_terminal( int repeat )
+{
+  search_thread *t = &bench_thread;
+  uint64_t checksum = 0;
+  long long usec = 0, start;
+  int i, r, sum;
+
+  for( i = 0; i < num_samples; i++ ) {
+    t->pos = sample_pos[i];
+    sum = 0;
+    start = clock_usec();
+    for( r = 0; r < repeat; r++ ) {
+      sum += evaluate_terminal( t, r & 1 );
+    }
+    usec += clock_usec() - start;
+    checksum = mix( checksum, evaluate_terminal( t, 0 ));
+    checksum = mix( checksum, sum );
+  }
+  report( "evaluate_terminal", ( long )num_samples * repeat, usec, checksum );
+}
+
+/*********************************************************//*
+   Time gamewon, for both players on every sub-board of every sample
+*/
+void bench_gamewon( int repeat )
+{
+  uint64_t checksum = 0;
+  long long usec = 0, start;
+  int i, r, b, sum;
+
+  for( i = 0; i < num_samples; i++ ) {
+    sum = 0;
+    start = clock_usec();
+    for( r = 0; r < repeat; r++ ) {
+      for( b = 1; b <= 9; b++ ) {
+        sum += gamewon( r & 1, sample_cells[i][b] );
+      }
+    }
+    usec += clock_usec() - start;
+    checksum = mix( checksum, sum );
+  }
+  report( "gamewon", ( long )num_samples * repeat * 9, usec, checksum );
+}
+
+/*********************************************************//*
+   Time make_move from game.c, replaying every game and taking
+   the moves back again afterwards
+*/
+void bench_make_move( int repeat )
+{
+  int board[10][10];
+  uint64_t checksum = 0;
+  long long usec = 0, start;
+  long ops = 0;
+  int g, r, m, status;
+
+  reset_board( board );
+  for( g = 0; g < num_games; g++ ) {
+    bench_game *game = &games[g];
+    start = clock_usec();
+    for( r = 0; r < repeat; r++ ) {
+      for( m = 1; m <= game->last; m++ ) {
+        status = make_move( !( m & 1 ), m, game->move, board );
+        checksum = mix( checksum, status );
+      }
+      for( m = game->last; m >= 1; m-- ) {
+        board[game->move[m-1]][game->move[m]] = EMPTY;
+      }
+    }
+    usec += clock_usec() - start;
+    ops += ( long )repeat * game->last;
+  }
+  report( "make_move", ops, usec, checksum );
+}
+
+/*********************************************************//*
+   Time pos_make and pos_unmake, the bitboard version of make_move
+   that the search uses, in the same way
+*/
+void bench_pos_make( int repeat )
+{
+  position p;
+  uint64_t checksum = 0;
+  long long usec = 0, start;
+  long ops = 0;
+  int g, r, m, status;
+
+  pos_reset( &p );
+  for( g = 0; g < num_games; g++ ) {
+    bench_game *game = &games[g];
+    start = clock_usec();
+    for( r = 0; r < repeat; r++ ) {
+      for( m = 1; m <= game->last; m++ ) {
+        status = pos_make( &p, !( m & 1 ), game->move[m-1], game->move[m] );
+        checksum = mix( checksum, status + p.total );
+      }
+      for( m = game->last; m >= 1; m-- ) {
+        pos_unmake( &p, !( m & 1 ), game->move[m-1], game->move[m] );
+      }
+    }
+    usec += clock_usec() - start;
+    ops += ( long )repeat * game->last;
+  }
+  checksum = mix( checksum, ( int )( p.hash ^ ( p.hash >> 32 )));
+  report( "pos_make/unmake", ops, usec, checksum );
+}
+
+/*********************************************************//*
+   Search each position from the file to a fixed depth with
+   alpha_beta_search itself, with a full window and an empty
+   table, so no iterative deepening or aspiration windows
+*/
+void bench_alpha_beta( int depth )
+{
+  search_thread *t = &bench_thread;
+  uint64_t checksum = 0;
+  long long usec = 0, start;
+  long total_nodes = 0;
+  int g, m, p, score;
+
+  bench_engine->search_start = clock_usec();
+  set_search_stop( bench_engine, FALSE );
+  bench_engine->soft_limit = bench_engine->hard_limit = 1 << 30;
+
+  for( g = 0; g < num_games; g++ ) {
+    bench_game *game = &games[g];
+    memset( t, 0, sizeof( *t ));
+    t->e = bench_engine;
+    pos_reset( &t->pos );
+    p = 0;
+    for( m = 1; m <= game->first; m++ ) {
+      pos_make( &t->pos, p, game->move[m-1], game->move[m] );
+      p = !p;
+    }
+    t->root_depth = depth;
+    tt_clear( &bench_engine->tt );
+    tt_new_search( &bench_engine->tt );
+
+    start = clock_usec();
+    score = alpha_beta_search( t, game->move[game->first], depth, -200, 200, p );
+    usec += clock_usec() - start;
+
+    total_nodes += t->nodes;
+    checksum = mix( checksum, score );
+    checksum = mix( checksum, t->pv_length[0] > 0 ? t->pv[0][0] : 0 );
+    checksum = mix( checksum, ( int )t->nodes );
+  }
+  printf("%-20s depth %d  positions %d  nodes %ld  %.0f nodes/s  %.1f msec  checksum %016llx\n",
+         "alpha_beta_search", depth, num_games, total_nodes,
+         usec ? total_nodes * 1000000.0 / usec : 0.0, usec / 1000.0,
+         ( unsigned long long )checksum );
+}
+
+/*********************************************************/
+int main( int argc, char *argv[] )
+{
+  char *file = "positions.txt";
+  int depth = 10;
+  int repeat = 10000;
+  int megabytes = 32;
+  char line[256];
+  FILE *fp;
+  int i=1;
+
+  while( i < argc ) {
+    if( strcmp( argv[i], "-d" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      depth = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-r" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      repeat = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-m" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      megabytes = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( argv[i][0] != '-' ) {
+      file = argv[i];
+      i++;
+    }
+    else {
+      usage( argv[0] );
+    }
+  }
+  if( depth <= 0 || depth >= MAX_PLY || repeat <= 0 || megabytes <= 0 ) {
+    usage( argv[0] );
+  }
+
+  fp = fopen( file, "r" );
+  if( fp == NULL ) {
+    perror( file );
+    exit(1);
+  }
+  srandom( 3411 );
+  while( num_games < MAX_GAMES && fgets( line, sizeof( line ), fp ) != NULL ) {
+    if( play_game( line, &games[num_games] )) {
+      num_games++;
+    }
+  }
+  fclose( fp );
+
+  printf("games %d  samples %d  repeat %d\n", num_games, num_samples, repeat );
+  bench_engine = engine_new( megabytes );
+  if( bench_engine == NULL ) {
+    fprintf( stderr, "out of memory\n" );
+    exit(1);
+  }
+  bench_thread.e = bench_engine;
+  bench_heuristic( repeat );
+  bench_terminal( repeat );
+  bench_gamewon( repeat );
+  bench_make_move( repeat );
+  bench_pos_make( repeat );
+  bench_alpha_beta( depth );
+  engine_free( bench_engine );
+  return 0;
+}
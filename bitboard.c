@@ -0,0 +1,19 @@
+/*********************************************************
+ *  bitboard.c
+ *  Nine-Board Tic-Tac-Toe Bitboard Position
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#include <string.h>
+
+#include "common.h"
+#include "bitboard.h"
+
+/*********************************************************
+   Clear every sub-board
+*/
+void pos_reset( position *pos )
+{
+  memset( pos, 0, sizeof( position ));
+  pos->status = STILL_PLAYING;
+}
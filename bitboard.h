@@ -0,0 +1,116 @@
+/*********************************************************
+ *  bitboard.h
+ *  Nine-Board Tic-Tac-Toe Bitboard Position
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#ifndef BITBOARD_H
+#define BITBOARD_H
+
+#include <stdint.h>
+
+#include "common.h"
+#include "tables.h"
+
+// Each sub-board is held as one 9-bit mask per player, with cell c
+// (numbered 1 to 9 as in the protocol) stored in bit c-1.
+#define CELL_BIT(c)    (1 << ((c) - 1))
+#define FULL_MASK      0x1FF
+
+typedef struct {
+  uint16_t bb[2][10];  // bb[player][board], board numbered 1 to 9
+  int8_t   score[10];  // pattern_score of each sub-board
+  uint16_t threat[2][10]; // empty cells where each player would complete a line
+  int      total;      // sum of score[1..9], from X's view
+  int      status;     // STILL_PLAYING, or WIN or DRAW after the last move
+  uint64_t hash;       // Zobrist hash of the pieces on the board
+} position;
+
+// The three rows, three columns and two diagonals of a sub-board.
+static const uint16_t win_lines[8] = {
+  0x007, 0x038, 0x1C0,  // rows    1-2-3, 4-5-6, 7-8-9
+  0x049, 0x092, 0x124,  // columns 1-4-7, 2-5-8, 3-6-9
+  0x111, 0x054          // diagonals 1-5-9, 3-5-7
+};
+
+// Number of pieces in a 9-bit mask, built up two bits at a time.
+#define POP2(n)  n, n+1, n+1, n+2
+#define POP4(n)  POP2(n), POP2(n+1), POP2(n+1), POP2(n+2)
+#define POP6(n)  POP4(n), POP4(n+1), POP4(n+1), POP4(n+2)
+#define POP8(n)  POP6(n), POP6(n+1), POP6(n+1), POP6(n+2)
+static const uint8_t pop_count[512] = { POP8(0), POP8(1) };
+
+// Clear every sub-board
+void pos_reset( position *pos );
+
+/*********************************************************
+   Mask of the empty cells on a sub-board
+*/
+static inline int pos_empty( const position *pos, int b )
+{
+  return ~( pos->bb[0][b] | pos->bb[1][b] ) & FULL_MASK;
+}
+
+/*********************************************************
+   Return TRUE if the sub-board is full
+*/
+static inline int pos_full( const position *pos, int b )
+{
+  return ( pos->bb[0][b] | pos->bb[1][b] ) == FULL_MASK;
+}
+
+/*********************************************************
+   Return TRUE if the mask contains three in a row
+*/
+static inline int mask_won( int mask )
+{
+  // Shifting the mask lines up the cells of every row (or every column)
+  // at once, so each test covers three lines in one step.
+  return(  ( mask & ( mask >> 1 ) & ( mask >> 2 ) & 0x049 )
+         ||( mask & ( mask >> 3 ) & ( mask >> 6 ) & 0x007 )
+         ||( mask & 0x111 ) == 0x111
+         ||( mask & 0x054 ) == 0x054 );
+}
+
+/*********************************************************
+   Play cell c of sub-board b for player p, updating the hash and
+   the cached score and threats of that sub-board only, and return
+   the game status in the same way as make_move in game.c
+*/
+static inline int pos_make( position *pos, int p, int b, int c )
+{
+  int i;
+  pos->bb[p][b] |= CELL_BIT(c);
+  pos->hash ^= zobrist[p][b][c];
+  i = pattern_index( pos->bb[0][b],pos->bb[1][b] );
+  pos->total += pattern_score[i] - pos->score[b];
+  pos->score[b] = pattern_score[i];
+  pos->threat[0][b] = pattern_threat[0][i];
+  pos->threat[1][b] = pattern_threat[1][i];
+
+  if( pattern_flags[i] & PATTERN_WON(p) ) {
+    pos->status = WIN;
+  }
+  else if( pos_full( pos,c )) {
+    pos->status = DRAW;  // next player has nowhere to go
+  }
+  return( pos->status );
+}
+
+/*********************************************************
+   Take back a move made by pos_make
+*/
+static inline void pos_unmake( position *pos, int p, int b, int c )
+{
+  int i;
+  pos->bb[p][b] &= ~CELL_BIT(c);
+  pos->hash ^= zobrist[p][b][c];
+  i = pattern_index( pos->bb[0][b],pos->bb[1][b] );
+  pos->total += pattern_score[i] - pos->score[b];
+  pos->score[b] = pattern_score[i];
+  pos->threat[0][b] = pattern_threat[0][i];
+  pos->threat[1][b] = pattern_threat[1][i];
+  pos->status = STILL_PLAYING;
+}
+
+#endif
@@ -0,0 +1,92 @@
+/*********************************************************
+ *  book.c
+ *  Nine-Board Tic-Tac-Toe Opening Book
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#include <stdio.h>
+#include <string.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#include "common.h"
+#include "book.h"
+
+static const book_file *book = NULL;
+
+/*********************************************************//*
+   Map a book into memory, returning FALSE if it is missing or stale
+*/
+int book_open( const char *path )
+{
+  struct stat st;
+  void *p;
+  int fd;
+
+  book_close();
+  fd = open( path, O_RDONLY );
+  if( fd < 0 ) {
+    return( FALSE );
+  }
+  if( fstat( fd, &st ) < 0 || st.st_size != sizeof( book_file )) {
+    fprintf( stderr, "%s: not an opening book\n", path );
+    close( fd );
+    return( FALSE );
+  }
+  p = mmap( NULL, sizeof( book_file ), PROT_READ, MAP_PRIVATE, fd, 0 );
+  close( fd );
+  if( p == MAP_FAILED ) {
+    perror( path );
+    return( FALSE );
+  }
+
+  book = p;
+  if(   memcmp( book->magic, BOOK_MAGIC, 4 ) != 0
+     || book->version != BOOK_VERSION
+     || book->size    != sizeof( book_file )) {
+    fprintf( stderr, "%s: stale opening book, ignored\n", path );
+    book_close();
+    return( FALSE );
+  }
+  return( TRUE );
+}
+
+/*********************************************************//*
+   Move for agent_second_move, or 0 if the book has none
+*/
+int book_second_move( int board_num, int prev_move )
+{
+  if(   book == NULL
+     || board_num < 1 || board_num > 9
+     || prev_move < 1 || prev_move > 9 ) {
+    return( 0 );
+  }
+  return( book->second[board_num][prev_move] );
+}
+
+/*********************************************************//*
+   Move for agent_third_move, or 0 if the book has none
+*/
+int book_third_move( int board_num, int first_move, int prev_move )
+{
+  if(   book == NULL
+     || board_num  < 1 || board_num  > 9
+     || first_move < 1 || first_move > 9
+     || prev_move  < 1 || prev_move  > 9 ) {
+    return( 0 );
+  }
+  return( book->third[board_num][first_move][prev_move] );
+}
+
+/*********************************************************//*
+   Unmap the book
+*/
+void book_close()
+{
+  if( book != NULL ) {
+    munmap(( void * )book, sizeof( book_file ));
+    book = NULL;
+  }
+}
@@ -0,0 +1,40 @@
+/*********************************************************
+ *  book.h
+ *  Nine-Board Tic-Tac-Toe Opening Book
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#ifndef BOOK_H
+#define BOOK_H
+
+#include <stdint.h>
+
+// The book file is this structure written out as it is, so the agent can
+// map it into memory and read the answer to an opening straight out of it.
+// BOOK_VERSION must go up whenever the layout, or the search that fills it
+// in, changes enough that an old book should no longer be trusted.
+#define BOOK_MAGIC    "NBTB"
+#define BOOK_VERSION  1
+
+typedef struct {
+  char     magic[4];            // BOOK_MAGIC
+  uint32_t version;             // BOOK_VERSION
+  uint32_t size;                // sizeof( book_file )
+  uint32_t depth;               // depth each opening was searched to
+  uint8_t  second[10][10];      // [board_num][prev_move], or 0 if not known
+  uint8_t  third[10][10][10];   // [board_num][first_move][prev_move], or 0
+} book_file;
+
+// Map a book into memory, returning FALSE if it is missing or stale
+int book_open( const char *path );
+
+// Move for agent_second_move, or 0 if the book has none
+int book_second_move( int board_num, int prev_move );
+
+// Move for agent_third_move, or 0 if the book has none
+int book_third_move( int board_num, int first_move, int prev_move );
+
+// Unmap the book
+void book_close();
+
+#endif
@@ -12,13 +12,16 @@
 #include <netinet/tcp.h>
 #include <netdb.h>
 #include <unistd.h>
+#include <pthread.h>
 
 #include "common.h"
 #include "agent.h"
+#include "search.h"
 
 int   port=31415;
 char *local="localhost";
 char *host;
+int   workers=0;  // 0 for one for each processor
 
 int pipe_fd;
 
@@ -27,11 +30,46 @@ FILE* pipe_out_stream;
 
 char client_buf[256];
 
+// When the server plays several games at once, every message starts with
+// the game's number. The move requests are queued for a pool of worker
+// threads, which write each reply as soon as it is found, and everything
+// else is done straight away by the thread reading the connection.
+#define MAX_JOBS 64
+
+typedef struct {
+  int id;
+  int m;          // 2, 3 or 4 for second_move, third_move or next_move
+  int board_num;
+  int first_move;
+  int prev_move;
+  long long asked;  // when the request arrived, from clock_usec()
+} client_job;
+
+int multi = FALSE;
+client_job jobs[MAX_JOBS];
+int job_head = 0, job_count = 0;
+int quit_workers = FALSE;
+pthread_t *worker_threads;
+int num_workers = 0;
+pthread_mutex_t job_lock = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t  job_ready = PTHREAD_COND_INITIALIZER;
+pthread_mutex_t write_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /*********************************************************//*
    Close the network connection
 */
 void client_cleanup()
 {
+  int k;
+
+  // any searches still going finish before the engines are freed
+  pthread_mutex_lock( &job_lock );
+  quit_workers = TRUE;
+  pthread_cond_broadcast( &job_ready );
+  pthread_mutex_unlock( &job_lock );
+  for( k = 0; k < num_workers; k++ ) {
+    pthread_join( worker_threads[k], NULL );
+  }
   agent_cleanup();
   fclose(pipe_in_stream);
   fclose(pipe_out_stream);
@@ -63,6 +101,7 @@ void client_second_move( int board_num, int prev_move )
   this_move = agent_second_move( board_num,prev_move );
   fprintf(pipe_out_stream, "%d\n",this_move);
   fflush(pipe_out_stream);
+  agent_ponder();
 }
 
 /*********************************************************//*
@@ -78,6 +117,7 @@ void client_third_move(
   this_move=agent_third_move(board_num,first_move,prev_move);
   fprintf(pipe_out_stream, "%d\n",this_move);
   fflush(pipe_out_stream);
+  agent_ponder();
 }
 
 /*********************************************************//*
@@ -89,6 +129,7 @@ void client_next_move( int prev_move )
   this_move = agent_next_move( prev_move );
   fprintf(pipe_out_stream,"%d\n",this_move);
   fflush(pipe_out_stream);
+  agent_ponder();
 }
 
 /*********************************************************//*
@@ -139,90 +180,243 @@ int tcpopen()
 int get_cause( char *buf )
 {
   int cause=TRIPLE;
-  if( strcmp(client_buf,"triple).") == 0) {
+  if( strcmp(buf,"triple).") == 0) {
     cause = TRIPLE;
   }
-  else if( strcmp(client_buf,"timeout).") == 0) {
+  else if( strcmp(buf,"timeout).") == 0) {
     cause = TIMEOUT;
   }
-  else if( strcmp(client_buf,"illegal_move).") == 0) {
+  else if( strcmp(buf,"illegal_move).") == 0) {
     cause = ILLEGAL_MOVE;
   }
-  else if( strcmp(client_buf,"full_board).") == 0) {
+  else if( strcmp(buf,"full_board).") == 0) {
     cause = FULL_BOARD;
   }
   return( cause );
 }
 
-/*********************************************************/
-int main(int argc, char** argv)
+/*********************************************************//*
+   Body of a worker thread, which finds the moves asked for in
+   the games played at once and writes them back
+*/
+void *client_worker( void *arg )
 {
-  int player=0;
-  int result=DRAW;  // WIN, LOSS or DRAW
-  int cause =TRIPLE;// TRIPLE, TIMEOUT, ILLEGAL_MOVE or FULL_BOARD
-  int board_num,first_move,prev_move;
-  int sd;
-  char ch;
+  client_job job;
+  int this_move;
 
-  host = local; // default
-  agent_parse_args( argc, argv );
+  while( TRUE ) {
+    pthread_mutex_lock( &job_lock );
+    while( job_count == 0 && !quit_workers ) {
+      pthread_cond_wait( &job_ready, &job_lock );
+    }
+    if( job_count == 0 ) {
+      pthread_mutex_unlock( &job_lock );
+      return( NULL );
+    }
+    job = jobs[job_head];
+    job_head = ( job_head + 1 ) % MAX_JOBS;
+    job_count--;
+    pthread_mutex_unlock( &job_lock );
 
-  sd = tcpopen(); // host,port );
+    if( job.m == 2 ) {
+      this_move = agent_game_second_move( job.id,job.asked,job.board_num,job.prev_move );
+    }
+    else if( job.m == 3 ) {
+      this_move = agent_game_third_move( job.id,job.asked,job.board_num,job.first_move,job.prev_move );
+    }
+    else {
+      this_move = agent_game_next_move( job.id,job.asked,job.prev_move );
+    }
+    if( this_move == 0 ) {
+      continue;   // the game was over before its move was found
+    }
 
-  pipe_fd = sd;
-  pipe_in_stream  = fdopen(sd,"r");
-  pipe_out_stream = fdopen(sd,"w");
+    pthread_mutex_lock( &write_lock );
+    fprintf(pipe_out_stream, "%d:%d\n",job.id,this_move);
+    fflush(pipe_out_stream);
+    pthread_mutex_unlock( &write_lock );
+  }
+}
 
-  client_buf[0] = '\0';
-  pipe_read(client_buf);
+/*********************************************************//*
+   Queue a move request from one of the games played at once
+*/
+void client_queue( int id, int m, int board_num, int first_move, int prev_move )
+{
+  client_job *job;
 
-  while( TRUE ) {
-    if(strcmp(client_buf,"init.") == 0) {
-      agent_init();
+  pthread_mutex_lock( &job_lock );
+  if( job_count == MAX_JOBS ) {
+    // the server never has more requests out than games agreed
+    fprintf( stderr, "too many move requests\n" );
+    exit(1);
+  }
+  job = &jobs[( job_head + job_count ) % MAX_JOBS];
+  job->id = id;
+  job->m = m;
+  job->board_num = board_num;
+  job->first_move = first_move;
+  job->prev_move = prev_move;
+  job->asked = clock_usec();
+  job_count++;
+  pthread_cond_signal( &job_ready );
+  pthread_mutex_unlock( &job_lock );
+}
+
+/*********************************************************//*
+   Agree to play up to max_games games at once, and start the workers,
+   or answer multi(0). to go on playing one game at a time
+*/
+void client_multi( int max_games )
+{
+  int games, k;
+
+  if( max_games > MAX_JOBS ) {
+    max_games = MAX_JOBS;
+  }
+  games = agent_multi( max_games );
+  if( games > 0 ) {
+    num_workers = workers > 0 ? workers : ( int )sysconf( _SC_NPROCESSORS_ONLN );
+    if( num_workers < 1 ) {
+      num_workers = 1;
+    }
+    if( num_workers > games ) {
+      num_workers = games;
+    }
+    worker_threads = malloc( num_workers * sizeof( pthread_t ));
+    for( k = 0; k < num_workers; k++ ) {
+      if( worker_threads == NULL
+         || pthread_create( &worker_threads[k], NULL, client_worker, NULL ) != 0 ) {
+        num_workers = k;
+        break;
+      }
+    }
+    if( num_workers == 0 ) {
+      games = 0;
+    }
+  }
+  multi = ( games > 0 );
+  pthread_mutex_lock( &write_lock );
+  fprintf(pipe_out_stream, "multi(%d).\n",games);
+  fflush(pipe_out_stream);
+  pthread_mutex_unlock( &write_lock );
+}
+
+/*********************************************************//*
+   Act on a message from the server, about game id if several
+   games are played at once, or else with id 0
+*/
+void client_message( int id, char *buf )
+{
+  int player;
+  int result;       // WIN, LOSS or DRAW
+  int cause;        // TRIPLE, TIMEOUT, ILLEGAL_MOVE or FULL_BOARD
+  int board_num,first_move,prev_move,games;
+  int msec_left,msec_per_move;
+  char ch;
+
+  if(strcmp(buf,"init.") == 0) {
+    agent_init();
+  }
+  else if(sscanf(buf,"multi(%d).",&games) == 1) {
+    if( !multi ) {
+      client_multi( games );
+    }
+  }
+  else if(sscanf(buf,"start(%c).",&ch) == 1) {
+    player = ( ch == 'x' ) ? 0 : 1 ;
+    if( id ) {
+      agent_game_start( id,player );
     }
-    else if(sscanf(client_buf,"start(%c).",&ch) == 1) {
-      player = ( ch == 'x' ) ? 0 : 1 ;
+    else {
       agent_start( player );
     }
-    else if(sscanf(client_buf,"second_move(%d,%d).",
-                   &board_num,&prev_move) == 2 ) {
+  }
+  else if(sscanf(buf,"second_move(%d,%d).",
+                 &board_num,&prev_move) == 2 ) {
+    if( id ) {
+      client_queue( id,2,board_num,0,prev_move );
+    }
+    else {
       client_second_move( board_num,prev_move );
     }
-    else if(sscanf(client_buf,"third_move(%d,%d,%d).",
-                   &board_num,&first_move,&prev_move) == 3) {
+  }
+  else if(sscanf(buf,"third_move(%d,%d,%d).",
+                 &board_num,&first_move,&prev_move) == 3) {
+    if( id ) {
+      client_queue( id,3,board_num,first_move,prev_move );
+    }
+    else {
       client_third_move( board_num,first_move,prev_move );
     }
-    else if(sscanf(client_buf,"next_move(%d).",&prev_move)==1){
+  }
+  else if(sscanf(buf,"next_move(%d).",&prev_move)==1){
+    if( id ) {
+      client_queue( id,4,0,0,prev_move );
+    }
+    else {
       client_next_move( prev_move );
     }
-    else if(sscanf(client_buf,"last_move(%d).",&prev_move)==1){
-      agent_last_move( prev_move );
+  }
+  else if(sscanf(buf,"clock(%d,%d).",&msec_left,&msec_per_move)==2){
+    if( id ) {
+      agent_game_clock( id,msec_left,msec_per_move );
     }
-    else if(   strcmp(client_buf,"win(") > 0
-            && strcmp(client_buf,"win)") < 0 ) {
-      result = WIN;
-      cause = get_cause(client_buf+4);
-      agent_gameover(result,cause);
+    else {
+      agent_clock( msec_left,msec_per_move );
     }
-    else if(   strcmp(client_buf,"loss(") > 0
-            && strcmp(client_buf,"loss)") < 0 ) {
-      result = LOSS;
-      cause = get_cause(client_buf+5);
-      agent_gameover(result,cause);
+  }
+  else if(sscanf(buf,"last_move(%d).",&prev_move)==1){
+    if( id ) {
+      agent_game_last_move( id,prev_move );
+    }
+    else {
+      agent_last_move( prev_move );
     }
-    else if(   strcmp(client_buf,"draw(") > 0
-            && strcmp(client_buf,"draw)") < 0 ) {
-      result = DRAW;
-      cause = get_cause(client_buf+5);
-      agent_gameover(result,cause);
+  }
+  else if(   strncmp(buf,"win(",4) == 0
+          || strncmp(buf,"loss(",5) == 0
+          || strncmp(buf,"draw(",5) == 0 ) {
+    result = buf[0] == 'w' ? WIN : buf[0] == 'l' ? LOSS : DRAW;
+    cause = get_cause(strchr(buf,'(')+1);
+    if( id ) {
+      agent_game_over( id,result,cause );
     }
-    else if(strcmp(client_buf,"end") == 0) {
-      client_cleanup();
-      return 0;
+    else {
+      agent_gameover( result,cause );
     }
+  }
+  else if(strcmp(buf,"end") == 0 || strcmp(buf,"end.") == 0) {
+    client_cleanup();
+  }
+}
+
+/*********************************************************/
+int main(int argc, char** argv)
+{
+  int sd, id, n;
+
+  host = local; // default
+  agent_parse_args( argc, argv );
+
+  sd = tcpopen(); // host,port );
 
+  pipe_fd = sd;
+  pipe_in_stream  = fdopen(sd,"r");
+  pipe_out_stream = fdopen(sd,"w");
+
+  while( TRUE ) {
     client_buf[0] = '\0';
     pipe_read(client_buf);
+
+    // n is only set if the number is followed by a colon
+    n = -1;
+    if( multi && sscanf(client_buf,"%d:%n",&id,&n) == 1 && n >= 0 && id > 0 ) {
+      client_message( id,client_buf+n );
+    }
+    else {
+      client_message( 0,client_buf );
+    }
   }
 
   return 0;
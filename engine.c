@@ -0,0 +1,362 @@
+/*********************************************************
+ *  engine.c
+ *  Nine-Board Tic-Tac-Toe Engine
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Plays one game at a time for whoever owns the engine. The
+ *  agent keeps one of these and passes the server's commands on
+ *  to it, but a program may keep as many as it likes.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "bitboard.h"
+#include "ttable.h"
+#include "search.h"
+#include "solver.h"
+#include "proof.h"
+#include "stats.h"
+#include "book.h"
+#include "engine.h"
+
+// The server allows 30 seconds initially, plus 2 seconds for each move,
+// and the same values can be given to the agent with -t.
+#define MOVES_TO_GO   10   // share of our spare time we are prepared to use on one move
+#define SAFETY_MSEC  150   // allowance for network delay
+
+/*********************************************************//*
+   Make an engine with tables of the given size in all
+*/
+engine *engine_new( int megabytes )
+{
+  engine *e = calloc( 1, sizeof( engine ));
+  if( e == NULL ) {
+    return( NULL );
+  }
+  e->move_ordering = TRUE;
+  e->quiescence = TRUE;
+  e->num_threads = 1;
+  e->endgame_empties = 50;
+  e->seconds_initially = 30;
+  e->seconds_per_move = 2;
+
+  // The main thread is made now, so that there is always one to search with.
+  e->threads = calloc( 1, sizeof( search_thread ));
+  if( e->threads == NULL ) {
+    free( e );
+    return( NULL );
+  }
+  e->allocated_threads = 1;
+
+  // The transposition table is used by every search, so it gets half of the memory,
+  // and the solver and the proof search a quarter each, but at least a megabyte.
+  tt_init( &e->tt, megabytes / 2 > 1 ? megabytes / 2 : 1 );
+  solver_init( &e->solver, megabytes / 4 > 1 ? megabytes / 4 : 1 );
+  proof_init( &e->proof, megabytes / 4 > 1 ? megabytes / 4 : 1 );
+  pos_reset( &e->pos );
+  return( e );
+}
+
+/*********************************************************//*
+   Stop any search the engine is running and release it
+*/
+void engine_free( engine *e )
+{
+  if( e == NULL ) {
+    return;
+  }
+  engine_gameover( e, DRAW, FULL_BOARD );
+  tt_free( &e->tt );
+  solver_free( &e->solver );
+  proof_free( &e->proof );
+  free( e->threads );
+  free( e );
+}
+
+/*********************************************************//*
+   Forget everything learned from earlier searches
+*/
+void engine_clear( engine *e )
+{
+  int k;
+  pos_reset( &e->pos );
+  tt_clear( &e->tt );
+  for( k = 0; k < e->allocated_threads; k++ ) {
+    memset( e->threads[k].history, 0, sizeof( e->threads[k].history ));
+  }
+}
+
+/*********************************************************//*
+   Start a new game
+*/
+void engine_start( engine *e, int this_player )
+{
+  engine_clear( e );
+  e->m = 0;
+  e->move[e->m] = 0;
+  e->player = this_player;
+
+  // the server starts our clock the same way
+  e->msec_left = 1000*( e->seconds_initially - e->seconds_per_move );
+  e->msec_per_move = 1000 * e->seconds_per_move;
+  e->told_msec_left = -1;
+}
+
+/*********************************************************//*
+   Take the time left on our clock from the server
+*/
+void engine_clock( engine *e, int msec_left, int msec_per_move )
+{
+  e->told_msec_left = msec_left;
+  e->msec_per_move = msec_per_move;
+}
+
+/*********************************************************//*
+   Decide how long the search for this move may take
+*/
+void plan_move_time( engine *e )
+{
+  // Each move brings msec_per_move more time, and anything not used is banked.
+  // We allow ourselves the time for this move plus a share of what has been banked,
+  // but never more than is actually left on the clock.
+  int banked = e->msec_left - e->msec_per_move;
+  int budget = e->msec_per_move + banked / MOVES_TO_GO;
+
+  e->hard_limit = budget - SAFETY_MSEC;
+  if( e->hard_limit > e->msec_left - SAFETY_MSEC ) {
+    e->hard_limit = e->msec_left - SAFETY_MSEC;
+  }
+  if( e->hard_limit < 0 ) {
+    e->hard_limit = 0;
+  }
+
+  // A search usually takes a few times longer than the one before it, so there is
+  // little chance of finishing one that starts after half the time has gone.
+  e->soft_limit = e->hard_limit / 2;
+}
+
+/*********************************************************//*
+   Search the position the opponent faces until told to stop
+*/
+void *ponder_search( void *arg )
+{
+  engine *e = arg;
+  setup_search( e, e->move[e->m], !e->player );
+  if( e->verbose ) {
+    fprintf( stderr, "ponder " );
+    print_search( e, stderr );
+  }
+  return( NULL );
+}
+
+/*********************************************************//*
+   Start thinking on the opponent's time, after our move has been sent
+*/
+void engine_ponder( engine *e )
+{
+  if( !e->ponder || e->pondering || e->pos.status != STILL_PLAYING ) {
+    return;
+  }
+  // The search has no time limit of its own, it runs until the opponent replies.
+  e->search_start = clock_usec();
+  set_search_stop( e, FALSE );
+  e->soft_limit = e->hard_limit = 1 << 30;
+  if( pthread_create( &e->ponder_thread, NULL, ponder_search, e ) == 0 ) {
+    e->pondering = TRUE;
+  }
+}
+
+/*********************************************************//*
+   Stop thinking on the opponent's time, before pos is changed
+*/
+void stop_pondering( engine *e )
+{
+  if( e->pondering ) {
+    set_search_stop( e, TRUE );
+    pthread_join( e->ponder_thread, NULL );
+    e->pondering = FALSE;
+  }
+}
+
+/*********************************************************//*
+   Start our copy of the server's clock for a new move request
+*/
+void start_move_clock( engine *e )
+{
+  stop_pondering( e );
+
+  // The server's clock started when it asked for the move, which may have
+  // been a while ago if the request had to wait for a thread to search it.
+  e->search_start = e->move_asked ? e->move_asked : clock_usec();
+  e->move_asked = 0;
+  set_search_stop( e, FALSE );
+
+  // If the server has told us the time left we use that, and otherwise we
+  // keep our own copy of its clock, which can drift by the network delay.
+  if( e->told_msec_left >= 0 ) {
+    e->msec_left = e->told_msec_left;
+    e->told_msec_left = -1;
+  }
+  else {
+    e->msec_left += e->msec_per_move;
+  }
+  plan_move_time( e );
+}
+
+/*********************************************************//*
+   Charge the time taken by this move to our copy of the clock
+*/
+void stop_move_clock( engine *e, int searched )
+{
+  // Engines playing at once share stderr and the statistics file, so each
+  // report is written in one piece.
+  if( e->verbose && searched ) {
+    flockfile( stderr );
+    print_search( e, stderr );
+    funlockfile( stderr );
+  }
+  if( e->stats_file != NULL && searched ) {
+    flockfile( e->stats_file );
+    print_stats( e, e->stats_file, e->stats_file != stderr, e->m );
+    funlockfile( e->stats_file );
+  }
+  // The server charges the time to the usec, so rounding up keeps our copy
+  // from ever showing more time than it has.
+  e->msec_left -= ( int )(( clock_usec() - e->search_start + 999 ) / 1000 );
+}
+
+/*********************************************************//*
+   Return TRUE if a move from the book can be played in board b
+*/
+int book_move_ok( engine *e, int b, int this_move )
+{
+  if( this_move < 1 || this_move > 9 || !( pos_empty( &e->pos,b ) & CELL_BIT( this_move ))) {
+    return( FALSE );
+  }
+  if( e->verbose ) {
+    fprintf( stderr, "book move %d\n", this_move );
+  }
+  return( TRUE );
+}
+
+/*********************************************************//*
+   Choose second move and return it
+*/
+int engine_second_move( engine *e, int board_num, int prev_move )
+{
+  // Based on the information passed in through the arguments, we update the move list
+  // and the positions played on the board.
+  int this_move;
+  start_move_clock( e );
+  e->move[0] = board_num;
+  e->move[1] = prev_move;
+  pos_make( &e->pos, !e->player, board_num, prev_move );
+  e->m = 2;
+
+  // The book has a move for every second_move, unless it is missing. Otherwise we use the
+  // function setup_search to begin the alpha-beta search, with the final returned move from
+  // this search being assigned to this_move.
+  this_move = book_second_move( board_num,prev_move );
+  int searched = !book_move_ok( e,prev_move,this_move );
+  if( searched ) {
+    this_move = setup_search( e, prev_move, e->player );
+  }
+
+  // Finally, based on the move selected above, we update the move list and place this
+  // selection on the board.
+  e->move[e->m] = this_move;
+  pos_make( &e->pos, e->player, prev_move, this_move );
+  stop_move_clock( e, searched );
+  return( this_move );
+}
+
+/*********************************************************//*
+   Choose third move and return it
+*/
+int engine_third_move(
+                      engine *e,
+                      int board_num,
+                      int first_move,
+                      int prev_move
+                     )
+{
+  // Based on the information passed in through the arguments, we update the move list
+  // and the positions played on the board.
+  int this_move;
+  start_move_clock( e );
+  e->move[0] = board_num;
+  e->move[1] = first_move;
+  e->move[2] = prev_move;
+  pos_make( &e->pos,  e->player, board_num, first_move );
+  pos_make( &e->pos, !e->player, first_move, prev_move );
+  e->m = 3;
+
+  // The book has a move for every third_move, unless it is missing. Otherwise we use the
+  // function setup_search to begin the alpha-beta search, with the final returned move from
+  // this search being assigned to this_move.
+  this_move = book_third_move( board_num,first_move,prev_move );
+  int searched = !book_move_ok( e,prev_move,this_move );
+  if( searched ) {
+    this_move = setup_search( e, prev_move, e->player );
+  }
+
+  // Finally, based on the move selected above, we update the move list and place this
+  // selection on the board.
+  e->move[e->m] = this_move;
+  pos_make( &e->pos, e->player, e->move[e->m-1], this_move );
+  stop_move_clock( e, searched );
+  return( this_move );
+}
+
+/*********************************************************//*
+   Choose next move and return it
+*/
+int engine_next_move( engine *e, int prev_move )
+{
+  // Based on the information passed in through the arguments, we update the move list
+  // and the positions played on the board.
+  int this_move;
+  start_move_clock( e );
+  e->m++;
+  e->move[e->m] = prev_move;
+  pos_make( &e->pos, !e->player, e->move[e->m-1], e->move[e->m] );
+  e->m++;
+
+  // We then use the function setup_search to begin the alpha-beta search, with the final
+  // returned move from this search being assigned to this_move.
+  this_move = setup_search( e, prev_move, e->player );
+
+  // Finally, based on the move selected above, we update the move list and place this
+  // selection on the board.
+  e->move[e->m] = this_move;
+  pos_make( &e->pos, e->player, e->move[e->m-1], this_move );
+  stop_move_clock( e, TRUE );
+  return( this_move );
+}
+
+/*********************************************************//*
+   Receive last move and mark it on the board
+*/
+void engine_last_move( engine *e, int prev_move )
+{
+  stop_pondering( e );
+  e->m++;
+  e->move[e->m] = prev_move;
+  pos_make( &e->pos, !e->player, e->move[e->m-1], e->move[e->m] );
+}
+
+/*********************************************************//*
+   Called after each game
+*/
+void engine_gameover(
+                     engine *e,
+                     int result,// WIN, LOSS or DRAW
+                     int cause  // TRIPLE, ILLEGAL_MOVE, TIMEOUT or FULL_BOARD
+                    )
+{
+  stop_pondering( e );
+}
@@ -0,0 +1,139 @@
+/*********************************************************
+ *  engine.h
+ *  Nine-Board Tic-Tac-Toe Engine
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Everything one player needs to search and to keep track of its
+ *  game is held in an engine, so any number of them can be used
+ *  at once in one process, each on threads of its own. Engines
+ *  share nothing that changes, only the pattern tables and the
+ *  opening book, which are read-only.
+ */
+#ifndef ENGINE_H
+#define ENGINE_H
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "bitboard.h"
+#include "ttable.h"
+#include "solver.h"
+#include "proof.h"
+#include "stats.h"
+
+#define MAX_PLY     82
+#define MAX_THREADS 64
+#define MAX_MOVE    81
+
+typedef struct search_thread search_thread;
+
+typedef struct engine {
+  // how to search, which may be changed between searches
+  int  depth_limit;        // deepest search to try, or 0 for no limit
+  long node_limit;         // nodes each thread may search, or 0 for no limit
+  int  move_ordering;      // TRUE to try the most promising moves first
+  int  quiescence;         // TRUE to follow forced moves past the depth of the search
+  int  num_threads;        // threads to search with
+  int  endgame_empties;    // solve outright with this many empty cells or fewer, 50 by default,
+                           // unless there is a depth or node limit
+  int  proof_search;       // TRUE to look for forced wins alongside the main search
+
+  // the search in progress
+  position pos;            // the position being searched
+  long long search_start;  // when the search started, from clock_usec()
+  int soft_limit;          // don't start a deeper search after this many msec
+  int hard_limit;          // abandon the search after this many msec
+  int search_stop;         // set to make every thread give up its search, and cleared
+                           // by whoever starts the next one, through set_search_stop
+  search_thread *threads;
+  int allocated_threads;
+
+  // statistics for the most recent call to setup_search, summed over the threads
+  long nodes;
+  long cutoffs;            // nodes where a move failed high
+  long first_move_cutoffs; // ... and it was the first move tried
+  long researches;         // searches repeated with a wider window
+  search_stats last_stats; // only kept up to date when built with SEARCH_STATS
+
+  // result of the deepest search completed by setup_search
+  int search_depth;
+  int search_score;        // heuristic score, or 100, -100 or 0 if the result is known
+  int pv_line[MAX_PLY];    // principal variation, as the cells played
+  int pv_count;
+  int search_proof;        // WIN or LOSS if proven by the proof search or the
+                           // endgame solver, else STILL_PLAYING
+
+  tt_table tt;
+  solver_state solver;
+  proof_state proof;
+
+  // the game being played, as the server has told us about it
+  int move[MAX_MOVE+1];
+  int player;
+  int m;
+  int seconds_initially;
+  int seconds_per_move;
+  int msec_left;           // our copy of the time the server has left on our clock
+  int msec_per_move;       // time added for each move
+  int told_msec_left;      // time left as the server last told us, or -1
+  long long move_asked;    // when the next move was asked for, from clock_usec(), if
+                           // that was before it is searched for, else 0
+  int verbose;             // report each search on stderr
+  int ponder;              // search on the opponent's time
+  FILE *stats_file;        // where to write search statistics, or NULL
+  pthread_t ponder_thread;
+  int pondering;           // TRUE while ponder_thread is running
+} engine;
+
+/*********************************************************
+   Read search_stop, which other threads may set at any time. Relaxed
+   ordering is enough, as the flag guards no other data, and a thread
+   that sees it a little late only searches a few more nodes.
+*/
+static inline int search_stopped( engine *e )
+{
+  return __atomic_load_n( &e->search_stop, __ATOMIC_RELAXED );
+}
+
+/*********************************************************
+   Set or clear search_stop
+*/
+static inline void set_search_stop( engine *e, int stop )
+{
+  __atomic_store_n( &e->search_stop, stop, __ATOMIC_RELAXED );
+}
+
+// Make an engine whose tables take about the given number of megabytes between them,
+// set up to search as the agent does by default
+engine *engine_new( int megabytes );
+
+// Stop any search the engine is running and release it
+void engine_free( engine *e );
+
+// Empty the engine's position, transposition table and move history, so that
+// its next search does not depend on the ones before it
+void engine_clear( engine *e );
+
+// Start a new game, with the engine playing this_player
+void engine_start( engine *e, int this_player );
+
+// Choose the engine's second, third or later move of the game and return it
+int  engine_second_move( engine *e, int board_num, int prev_move );
+int  engine_third_move( engine *e, int board_num, int first_move, int prev_move );
+int  engine_next_move( engine *e, int prev_move );
+
+// Mark the move that ended the game on the board
+void engine_last_move( engine *e, int prev_move );
+
+// Take the time the server says is left on our clock for the next move, counting
+// the time added for it, and the time it adds for each move
+void engine_clock( engine *e, int msec_left, int msec_per_move );
+
+// Start thinking on the opponent's time, once our move has been sent
+void engine_ponder( engine *e );
+
+// Called at the end of each game
+void engine_gameover( engine *e, int result, int cause );
+
+#endif
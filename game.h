@@ -5,6 +5,7 @@
  *  Dion Earle, Assignment 3
  */
 void reset_board( int board[10][10] );
+int   gamewon( int p, int bb[10] );
 int   full_board( int bb[] );
 void print_board( FILE *fp,int board[10][10],
 		  int board_num,int prev_move );
@@ -0,0 +1,282 @@
+/*********************************************************
+ *  gamelog.c
+ *  Nine-Board Tic-Tac-Toe Game Log
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Writes games to a log and reads them back, a record at a time,
+ *  through a buffer of its own, so a log of any size can be read
+ *  without holding more than a little of it in memory.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "gamelog.h"
+
+static const int causes[4] = { TRIPLE, ILLEGAL_MOVE, TIMEOUT, FULL_BOARD };
+
+/*********************************************************//*
+   Open a log to append games to, writing its header if it is new
+*/
+gamelog *gamelog_append( const char *path )
+{
+  static const unsigned char header[8] = { 'N','B','T','G', GAMELOG_VERSION,0,0,0 };
+  gamelog *log = calloc( 1, sizeof( gamelog ));
+  if( log == NULL ) {
+    return( NULL );
+  }
+  log->fp = fopen( path, "ab" );
+  if( log->fp == NULL ) {
+    perror( path );
+    free( log );
+    return( NULL );
+  }
+  log->writing = TRUE;
+  if( ftell( log->fp ) == 0 ) {
+    fwrite( header, 1, sizeof( header ), log->fp );
+    fflush( log->fp );
+  }
+  return( log );
+}
+
+/*********************************************************//*
+   Open a log to read from the start
+*/
+gamelog *gamelog_open( const char *path )
+{
+  gamelog *log = malloc( sizeof( gamelog ));
+  if( log == NULL ) {
+    return( NULL );
+  }
+  log->fp = strcmp( path, "-" ) == 0 ? stdin : fopen( path, "rb" );
+  if( log->fp == NULL ) {
+    perror( path );
+    free( log );
+    return( NULL );
+  }
+  log->writing = FALSE;
+  log->pos = log->len = 0;
+  return( log );
+}
+
+/*********************************************************//*
+   Put a player's name into a record at p, and return the end of it
+*/
+static unsigned char *put_name( unsigned char *p, const char *name )
+{
+  int n = strlen( name );
+  if( n > GAMELOG_MAX_NAME ) {
+    n = GAMELOG_MAX_NAME;
+  }
+  *p++ = n;
+  memcpy( p, name, n );
+  return( p + n );
+}
+
+/*********************************************************//*
+   Append a game, in one write so that a game is never left half written
+*/
+int gamelog_write( gamelog *log, game_entry *g )
+{
+  unsigned char record[GAMELOG_MAX_RECORD];
+  unsigned char *p = record + 2;
+  int result, cause, m, len;
+
+  if(   !log->writing || g->length < 1 || g->length > GAMELOG_MAX_MOVE
+     || g->move[0] < 1 || g->move[0] > 9 ) {
+    return( FALSE );
+  }
+  result = g->result == WIN ? 0 : g->result == LOSS ? 1 : 2;
+  for( cause = 0; cause < 3 && causes[cause] != g->cause; cause++ )
+    ;
+  *p++ = result | cause << 2 | ( g->timed ? 0x10 : 0 );
+  *p++ = g->length;
+  p = put_name( p, g->players[0] );
+  p = put_name( p, g->players[1] );
+
+  memset( p, 0, ( g->length + 2 ) / 2 );
+  for( m = 0; m <= g->length; m++ ) {
+    int c = g->move[m] >= 1 && g->move[m] <= 9 ? g->move[m] : 0;
+    p[m/2] |= c << ( 4*( m % 2 ));
+  }
+  p += ( g->length + 2 ) / 2;
+
+  if( g->timed ) {
+    for( m = 1; m <= g->length; m++ ) {
+      unsigned int t = g->usec[m] > 0 ? g->usec[m] : 0;
+      while( t >= 0x80 ) {
+        *p++ = ( t & 0x7F ) | 0x80;
+        t >>= 7;
+      }
+      *p++ = t;
+    }
+  }
+
+  len = p - record - 2;
+  record[0] = len & 0xFF;
+  record[1] = len >> 8;
+  if( fwrite( record, 1, len + 2, log->fp ) != len + 2 ) {
+    return( FALSE );
+  }
+  return( fflush( log->fp ) == 0 );
+}
+
+/*********************************************************//*
+   Make sure at least n bytes are in the buffer, if the log has them
+*/
+static int fill( gamelog *log, int n )
+{
+  size_t got;
+  if( log->len - log->pos >= n ) {
+    return( TRUE );
+  }
+  memmove( log->buf, log->buf + log->pos, log->len - log->pos );
+  log->len -= log->pos;
+  log->pos = 0;
+  while( log->len < n ) {
+    got = fread( log->buf + log->len, 1, sizeof( log->buf ) - log->len, log->fp );
+    if( got == 0 ) {
+      return( FALSE );
+    }
+    log->len += got;
+  }
+  return( TRUE );
+}
+
+/*********************************************************//*
+   Find the next record without decoding it
+*/
+int gamelog_next( gamelog *log, const unsigned char **record, int *len )
+{
+  unsigned char *p;
+  int n;
+
+  while( fill( log, 2 )) {
+    p = log->buf + log->pos;
+    // The header of a log joined on to the end of another is passed over.
+    // No record is long enough for its length to look like the magic.
+    if( p[0] == GAMELOG_MAGIC[0] && p[1] == GAMELOG_MAGIC[1] ) {
+      if( !fill( log, 8 )) {
+        return( FALSE );
+      }
+      p = log->buf + log->pos;
+      if( memcmp( p, GAMELOG_MAGIC, 4 ) != 0 || p[4] != GAMELOG_VERSION ) {
+        fprintf( stderr, "not a game log, or of another version\n" );
+        return( FALSE );
+      }
+      log->pos += 8;
+      continue;
+    }
+    n = p[0] | p[1] << 8;
+    if( n > GAMELOG_MAX_RECORD - 2 || !fill( log, 2 + n )) {
+      fprintf( stderr, "game log is damaged or cut short\n" );
+      return( FALSE );
+    }
+    *record = log->buf + log->pos + 2;
+    *len = n;
+    log->pos += 2 + n;
+    return( TRUE );
+  }
+  return( FALSE );
+}
+
+/*********************************************************//*
+   Take a player's name out of a record
+*/
+static const unsigned char *get_name( const unsigned char *p, const unsigned char *end,
+                                      char *name )
+{
+  int n;
+  if( p >= end || *p > GAMELOG_MAX_NAME || p + 1 + *p > end ) {
+    return( NULL );
+  }
+  n = *p++;
+  memcpy( name, p, n );
+  name[n] = '\0';
+  return( p + n );
+}
+
+/*********************************************************//*
+   Decode a record found by gamelog_next
+*/
+int gamelog_decode( const unsigned char *record, int len, game_entry *g )
+{
+  const unsigned char *p = record, *end = record + len;
+  int m, shift;
+  unsigned int t;
+
+  if( len < 4 ) {
+    return( FALSE );
+  }
+  if(( p[0] & 3 ) == 3 || p[1] < 1 || p[1] > GAMELOG_MAX_MOVE ) {
+    return( FALSE );
+  }
+  g->result = ( p[0] & 3 ) == 0 ? WIN : ( p[0] & 3 ) == 1 ? LOSS : DRAW;
+  g->cause  = causes[( p[0] >> 2 ) & 3];
+  g->timed  = ( p[0] & 0x10 ) != 0;
+  g->length = p[1];
+  p += 2;
+  if(   ( p = get_name( p, end, g->players[0] )) == NULL
+     || ( p = get_name( p, end, g->players[1] )) == NULL
+     || p + ( g->length + 2 ) / 2 > end ) {
+    return( FALSE );
+  }
+
+  for( m = 0; m <= g->length; m++ ) {
+    g->move[m] = ( p[m/2] >> ( 4*( m % 2 ))) & 0xF;
+    if( g->move[m] > 9 ) {
+      return( FALSE );
+    }
+  }
+  p += ( g->length + 2 ) / 2;
+
+  g->usec[0] = 0;
+  for( m = 1; m <= g->length; m++ ) {
+    t = 0;
+    if( g->timed ) {
+      shift = 0;
+      do {
+        if( p >= end || shift > 28 ) {
+          return( FALSE );
+        }
+        t |= ( unsigned int )( *p & 0x7F ) << shift;
+        shift += 7;
+      } while( *p++ & 0x80 );
+    }
+    g->usec[m] = t;
+  }
+  return( TRUE );
+}
+
+/*********************************************************//*
+   Read and decode the next game
+*/
+int gamelog_read( gamelog *log, game_entry *g )
+{
+  const unsigned char *record;
+  int len;
+
+  while( gamelog_next( log, &record, &len )) {
+    if( gamelog_decode( record, len, g )) {
+      return( TRUE );
+    }
+    fprintf( stderr, "game log record could not be read, skipped\n" );
+  }
+  return( FALSE );
+}
+
+/*********************************************************//*
+   Flush and close a log
+*/
+void gamelog_close( gamelog *log )
+{
+  if( log == NULL ) {
+    return;
+  }
+  if( log->fp != stdin ) {
+    fclose( log->fp );
+  }
+  free( log );
+}
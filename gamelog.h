@@ -0,0 +1,75 @@
+/*********************************************************
+ *  gamelog.h
+ *  Nine-Board Tic-Tac-Toe Game Log
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#ifndef GAMELOG_H
+#define GAMELOG_H
+
+#include <stdio.h>
+#include <stdint.h>
+
+// A game log is a file of games, each written as it finishes and never
+// changed after, so a log can be added to by appending and several logs
+// joined with cat. The file starts with GAMELOG_MAGIC and GAMELOG_VERSION,
+// and each game after it is a record of
+//
+//   2 bytes   length of the rest of the record, low byte first
+//   1 byte    result in bits 0-1 (0 X won, 1 O won, 2 draw), cause in
+//             bits 2-3 (0 triple, 1 illegal_move, 2 timeout, 3 full_board),
+//             and bit 4 set if the moves were timed
+//   1 byte    moves made, the last of them at move[length]
+//   2 names   the players X and O, each as 1 byte of length then the name
+//   moves     move[0] to move[length], 4 bits each, the first in the low bits,
+//             with 0 for an illegal move that was not a square at all
+//   times     if timed, the usec each of move[1] to move[length] took,
+//             7 bits to a byte with the top bit set on all but the last
+//
+// so a game of 40 moves with short names takes around 30 bytes untimed.
+#define GAMELOG_MAGIC     "NBTG"
+#define GAMELOG_VERSION   1
+#define GAMELOG_MAX_MOVE  81
+#define GAMELOG_MAX_NAME  63
+#define GAMELOG_MAX_RECORD 1024
+
+typedef struct {
+  char players[2][GAMELOG_MAX_NAME+1];  // X and O
+  int  result;                   // WIN, LOSS or DRAW from X's point of view
+  int  cause;                    // TRIPLE, ILLEGAL_MOVE, TIMEOUT or FULL_BOARD
+  int  move[GAMELOG_MAX_MOVE+1]; // held as in servt, move[0] the sub-board of the first move
+  int  length;                   // moves made, the last of them at move[length]
+  int  timed;                    // TRUE if usec holds the time of each move
+  int  usec[GAMELOG_MAX_MOVE+1]; // time taken over each move, 0 if not timed
+} game_entry;
+
+typedef struct {
+  FILE *fp;
+  int   writing;
+  unsigned char buf[1 << 16];    // bytes read but not yet used
+  int   pos, len;
+} gamelog;
+
+// Open a log to append games to, creating it if need be, or NULL on error
+gamelog *gamelog_append( const char *path );
+
+// Open a log to read from the start, "-" being stdin, or NULL on error
+gamelog *gamelog_open( const char *path );
+
+// Append a game, returning FALSE if it could not be written
+int gamelog_write( gamelog *log, game_entry *g );
+
+// Find the next record without decoding it, returning its length in
+// *len and FALSE at the end of the log or if the rest is not a game
+int gamelog_next( gamelog *log, const unsigned char **record, int *len );
+
+// Decode a record found by gamelog_next, returning FALSE if it is not a game
+int gamelog_decode( const unsigned char *record, int len, game_entry *g );
+
+// Read and decode the next game, returning FALSE at the end of the log
+int gamelog_read( gamelog *log, game_entry *g );
+
+// Flush and close a log
+void gamelog_close( gamelog *log );
+
+#endif
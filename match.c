@@ -0,0 +1,249 @@
+/*********************************************************
+ *  match.c
+ *  Nine-Board Tic-Tac-Toe In-Process Games
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Plays games between two configurations of the search inside
+ *  one process, with make_move from game.c as the referee, so
+ *  no server, sockets or clocks are involved. Each side searches
+ *  with an engine of its own, made by the caller with engine_new.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "game.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "search.h"
+#include "match.h"
+
+/*********************************************************//*
+   Set a config to search to depth 6 with no other limits
+*/
+void config_default( engine_config *c )
+{
+  c->depth = 6;
+  c->nodes = 0;
+  c->msec = 0;
+  c->empties = 0;
+  c->quiescence = TRUE;
+  c->ordering = TRUE;
+}
+
+/*********************************************************//*
+   Change a config by a comma-separated list of settings
+*/
+int config_parse( char *spec, engine_config *c )
+{
+  char buf[256];
+  char *s;
+
+  if( strlen( spec ) >= sizeof( buf )) {
+    return( FALSE );
+  }
+  strcpy( buf, spec );
+  for( s = strtok( buf, "," ); s != NULL; s = strtok( NULL, "," )) {
+    if( sscanf( s, "depth=%d", &c->depth ) == 1 ) {
+      if( c->depth < 0 || c->depth >= MAX_PLY ) {
+        return( FALSE );
+      }
+    }
+    else if( sscanf( s, "nodes=%ld", &c->nodes ) == 1 ) {
+      if( c->nodes < 0 ) {
+        return( FALSE );
+      }
+    }
+    else if( sscanf( s, "msec=%d", &c->msec ) == 1 ) {
+      if( c->msec < 0 ) {
+        return( FALSE );
+      }
+    }
+    else if( sscanf( s, "empties=%d", &c->empties ) == 1 ) {
+      if( c->empties < 0 ) {
+        return( FALSE );
+      }
+    }
+    else if( strcmp( s, "quiesce" ) == 0 || strcmp( s, "noquiesce" ) == 0 ) {
+      c->quiescence = ( s[0] == 'q' );
+    }
+    else if( strcmp( s, "order" ) == 0 || strcmp( s, "noorder" ) == 0 ) {
+      c->ordering = ( s[0] == 'o' );
+    }
+    else {
+      return( FALSE );
+    }
+  }
+  return( TRUE );
+}
+
+/*********************************************************//*
+   Write a config in the form config_parse reads
+*/
+void config_print( FILE *fp, engine_config *c )
+{
+  fprintf( fp, "depth=%d,nodes=%ld,msec=%d,empties=%d,%s,%s",
+           c->depth, c->nodes, c->msec, c->empties,
+           c->quiescence ? "quiesce" : "noquiesce",
+           c->ordering ? "order" : "noorder" );
+}
+
+/*********************************************************//*
+   Read an opening written as in positions.txt
+*/
+int opening_read( char *line, game_record *g )
+{
+  int board[10][10];
+  char *s;
+
+  if( line[0] < '1' || line[0] > '9' ) {
+    return( FALSE );
+  }
+  reset_board( board );
+  g->move[0] = line[0] - '0';
+  g->length = 0;
+  for( s = line+1; *s >= '1' && *s <= '9' && g->length < MAX_MOVE; s++ ) {
+    g->length++;
+    g->move[g->length] = *s - '0';
+    if( make_move(( g->length+1 ) % 2,g->length,g->move,board ) != STILL_PLAYING ) {
+      return( FALSE );
+    }
+  }
+  return( TRUE );
+}
+
+/*********************************************************//*
+   Choose an opening, at random unless the first move is given
+*/
+void opening_random( game_record *g, int board_num, int square, int plies )
+{
+  int board[10][10];
+  int c, tries;
+
+  while( TRUE ) {
+    reset_board( board );
+    g->move[0] = board_num ? board_num : 1 + random()% 9;
+    g->move[1] = square ? square : 1 + random()% 9;
+    g->length = 1;
+    make_move( 0,1,g->move,board );
+
+    // The random moves after the first are chosen from those that
+    // leave the game still going, and if there are none we start again.
+    while( g->length <= plies ) {
+      for( tries = 0; tries < 100; tries++ ) {
+        c = 1 + random()% 9;
+        if( board[g->move[g->length]][c] == EMPTY ) {
+          g->move[g->length+1] = c;
+          if( make_move(( g->length+2 ) % 2,g->length+1,g->move,board ) == STILL_PLAYING ) {
+            break;
+          }
+          board[g->move[g->length]][c] = EMPTY;
+        }
+      }
+      if( tries == 100 ) {
+        break;
+      }
+      g->length++;
+    }
+    if( g->length > plies ) {
+      return;
+    }
+  }
+}
+
+/*********************************************************//*
+   Write the moves of a game as in positions.txt
+*/
+void record_print( FILE *fp, game_record *g )
+{
+  int m;
+  for( m = 0; m <= g->length; m++ ) {
+    fputc( '0' + g->move[m], fp );
+  }
+}
+
+/*********************************************************//*
+   Search the engine's position for the move of the player to
+   move in board b, as the config says
+*/
+int engine_move( engine *e, engine_config *c, int b, int player )
+{
+  e->depth_limit = c->depth;
+  e->node_limit = c->nodes;
+  e->endgame_empties = c->empties;
+  e->quiescence = c->quiescence;
+  e->move_ordering = c->ordering;
+
+  e->search_start = clock_usec();
+  set_search_stop( e, FALSE );
+  e->soft_limit = e->hard_limit = 1 << 30;
+  if( c->msec > 0 ) {
+    e->hard_limit = c->msec;
+    e->soft_limit = c->msec / 2;
+  }
+  return( setup_search( e,b,player ));
+}
+
+/*********************************************************//*
+   Play a game from the opening, returning the result for X
+*/
+int play_game( engine *engines[2], engine_config config[2], game_record *opening,
+               game_record *g, int *cause )
+{
+  int board[10][10];
+  int status = STILL_PLAYING;
+  int m, player, c, k;
+  long long start;
+
+  // Each side keeps its own position and transposition table, so neither
+  // profits from the other's searches, and both engines are emptied at the
+  // start of every game so that no game depends on the ones before it.
+  *g = *opening;
+  memset( g->usec, 0, sizeof( g->usec ));
+  reset_board( board );
+  for( k = 0; k < 2; k++ ) {
+    engine_clear( engines[k] );
+  }
+  for( m = 1; m <= g->length; m++ ) {
+    status = make_move(( m+1 ) % 2,m,g->move,board );
+    for( k = 0; k < 2; k++ ) {
+      pos_make( &engines[k]->pos,( m+1 ) % 2,g->move[m-1],g->move[m] );
+    }
+  }
+
+  m = g->length;
+  while( status == STILL_PLAYING && m < MAX_MOVE ) {
+    player = m % 2;
+    start = clock_usec();
+    c = engine_move( engines[player],&config[player],g->move[m],player );
+    m++;
+    g->move[m] = c;
+    g->usec[m] = ( int )( clock_usec() - start );
+    if( c < 1 || c > 9 ) {
+      status = ILLEGAL_MOVE;
+      break;
+    }
+    status = make_move( player,m,g->move,board );
+    if( status != ILLEGAL_MOVE ) {
+      for( k = 0; k < 2; k++ ) {
+        pos_make( &engines[k]->pos,player,g->move[m-1],c );
+      }
+    }
+  }
+  g->length = m;
+
+  // the player who made the last move won, drew, or made an illegal move
+  player = ( m+1 ) % 2;
+  if( status == WIN ) {
+    *cause = TRIPLE;
+    return( player == 0 ? WIN : LOSS );
+  }
+  if( status == ILLEGAL_MOVE ) {
+    *cause = ILLEGAL_MOVE;
+    return( player == 0 ? LOSS : WIN );
+  }
+  *cause = FULL_BOARD;
+  return( DRAW );
+}
@@ -0,0 +1,64 @@
+/*********************************************************
+ *  match.h
+ *  Nine-Board Tic-Tac-Toe In-Process Games
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#ifndef MATCH_H
+#define MATCH_H
+
+#include <stdio.h>
+
+#include "engine.h"
+
+// How one side searches for its moves. A limit of 0 means no limit, but at
+// least one of depth, nodes and msec should be given or a move could take
+// as long as the rest of the game.
+typedef struct {
+  int  depth;       // deepest search to try
+  long nodes;       // nodes each search may visit
+  int  msec;        // time each search may take
+  int  empties;     // solve exactly with this many empty cells or fewer, if
+                    // there is no depth or node limit
+  int  quiescence;  // TRUE to follow forced moves past the depth of the search
+  int  ordering;    // TRUE to try the most promising moves first
+} engine_config;
+
+// The moves of a game, or of the opening it starts from, held as in servt,
+// where move[0] is the sub-board of the first move.
+typedef struct {
+  int move[MAX_MOVE+1];
+  int length;   // moves made, the last of them at move[length]
+  int usec[MAX_MOVE+1];  // time play_game took to choose each move, 0 for the opening
+} game_record;
+
+// Set a config to search to depth 6 with no other limits
+void config_default( engine_config *c );
+
+// Change a config by a list like "depth=8,nodes=50000,noquiesce",
+// returning FALSE if it could not be understood
+int config_parse( char *spec, engine_config *c );
+
+// Write a config in the form config_parse reads
+void config_print( FILE *fp, engine_config *c );
+
+// Read an opening written as in positions.txt, returning FALSE if the
+// line does not hold one or the game is already over
+int opening_read( char *line, game_record *g );
+
+// Choose an opening as servt does, with the first move in the given board and
+// square, or at random if they are 0, followed by the given number of random
+// moves that do not end the game
+void opening_random( game_record *g, int board, int square, int plies );
+
+// Write the moves of a game as in positions.txt
+void record_print( FILE *fp, game_record *g );
+
+// Play a game from the opening, X searching with engines[0] as config[0] says
+// and O with engines[1] as config[1] says, with the moves played left in *g.
+// Returns WIN, LOSS or DRAW from X's point of view, and sets *cause to TRIPLE,
+// FULL_BOARD or ILLEGAL_MOVE.
+int play_game( engine *engines[2], engine_config config[2], game_record *opening,
+               game_record *g, int *cause );
+
+#endif
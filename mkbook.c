@@ -0,0 +1,159 @@
+/*********************************************************
+ *  mkbook.c
+ *  Nine-Board Tic-Tac-Toe Opening Book Generator
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Searches every position the agent can be given by
+ *  second_move or third_move to a fixed depth, and writes
+ *  the chosen moves to a book for the agent to read with -b.
+ *  The answers never change, so there is no reason for the
+ *  agent to spend its time working them out during a game.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "search.h"
+#include "book.h"
+
+/*********************************************************//*
+   Print usage information and exit
+*/
+void usage( char argv0[] )
+{
+  printf("Usage: %s\n",argv0);
+  printf("       [-d depth]\n");     // depth to search each opening to
+  printf("       [-j threads]\n");   // number of search threads
+  printf("       [-m megabytes]\n"); // memory for the search tables
+  printf("       [-o book]\n");      // file to write, book.bin by default
+  exit(1);
+}
+
+/*********************************************************//*
+   Search the engine's position, with player p to move in board_num
+*/
+int book_search( engine *e, int board_num, int p )
+{
+  // The table is kept from one opening to the next, since they share
+  // many of their positions.
+  e->search_start = clock_usec();
+  set_search_stop( e, FALSE );
+  e->soft_limit = e->hard_limit = 1 << 30;
+  return( setup_search( e, board_num, p ));
+}
+
+/*********************************************************/
+int main( int argc, char *argv[] )
+{
+  char *file = "book.bin";
+  int depth = 14;
+  int megabytes = 32;
+  int num_threads = 1;
+  book_file book;
+  engine *e;
+  FILE *fp;
+  int i=1, n=0;
+  int b, f, c;
+
+  while( i < argc ) {
+    if( strcmp( argv[i], "-d" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      depth = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-j" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      num_threads = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-m" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      megabytes = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-o" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      file = argv[i+1];
+      i += 2;
+    }
+    else {
+      usage( argv[0] );
+    }
+  }
+  if(   depth <= 0 || megabytes <= 0
+     || num_threads < 1 || num_threads > MAX_THREADS ) {
+    usage( argv[0] );
+  }
+
+  memset( &book, 0, sizeof( book ));
+  memcpy( book.magic, BOOK_MAGIC, 4 );
+  book.version = BOOK_VERSION;
+  book.size    = sizeof( book );
+  book.depth   = depth;
+
+  e = engine_new( megabytes );
+  if( e == NULL ) {
+    fprintf( stderr, "out of memory\n" );
+    exit(1);
+  }
+  e->depth_limit = depth;
+  e->num_threads = num_threads;
+
+  // second_move(board_num,prev_move): X has played prev_move on board_num,
+  // and O is to move on board prev_move
+  for( b = 1; b <= 9; b++ ) {
+    for( c = 1; c <= 9; c++ ) {
+      pos_reset( &e->pos );
+      pos_make( &e->pos, 0, b, c );
+      book.second[b][c] = book_search( e, c, 1 );
+      n++;
+    }
+    fprintf( stderr, "second_move(%d,*) done\n", b );
+  }
+
+  // third_move(board_num,first_move,prev_move): X has played first_move on
+  // board_num, O has replied with prev_move on board first_move, and X is
+  // to move on board prev_move. Replies to a cell that is already taken
+  // cannot happen, and are left as 0.
+  for( b = 1; b <= 9; b++ ) {
+    for( f = 1; f <= 9; f++ ) {
+      for( c = 1; c <= 9; c++ ) {
+        if( b == f && c == f ) {
+          continue;
+        }
+        pos_reset( &e->pos );
+        pos_make( &e->pos, 0, b, f );
+        pos_make( &e->pos, 1, f, c );
+        book.third[b][f][c] = book_search( e, c, 0 );
+        n++;
+      }
+    }
+    fprintf( stderr, "third_move(%d,*,*) done\n", b );
+  }
+
+  fp = fopen( file, "wb" );
+  if( fp == NULL ) {
+    perror( file );
+    exit(1);
+  }
+  if( fwrite( &book, sizeof( book ), 1, fp ) != 1 || fclose( fp ) != 0 ) {
+    perror( file );
+    exit(1);
+  }
+  printf("%d openings searched to depth %d, written to %s\n", n, depth, file );
+
+  engine_free( e );
+  return 0;
+}
@@ -0,0 +1,210 @@
+/*********************************************************
+ *  mktables.c
+ *  Nine-Board Tic-Tac-Toe Sub-Board Pattern Table Generator
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Writes tables.c to standard output. A sub-board has only
+ *  3^9 = 19683 states, so everything the agent needs to know
+ *  about one of them is worked out here once, using the same
+ *  cell-by-cell rules the agent's evaluation functions were
+ *  written with, and stored in tables indexed by state.
+ *  The Zobrist hash keys are generated here as well.
+ */
+#include <stdio.h>
+#include <stdint.h>
+
+#include "common.h"
+#include "game.h"
+#include "tables.h"
+
+// cells of each row, column and diagonal
+int lines[8][3] = {
+  {1,2,3},{4,5,6},{7,8,9},
+  {1,4,7},{2,5,8},{3,6,9},
+  {1,5,9},{3,5,7}
+};
+
+/*********************************************************
+   Unpack a state index into a sub-board, one base-3 digit
+   per cell: 0 for X, 1 for O and 2 for empty are stored as
+   digits 1, 2 and 0 respectively
+*/
+void decode( int index, int bb[10] )
+{
+  int c;
+  for( c = 1; c <= 9; c++ ) {
+    switch( index % 3 ) {
+      case 0: bb[c] = EMPTY; break;
+      case 1: bb[c] = 0;     break;
+      case 2: bb[c] = 1;     break;
+    }
+    index /= 3;
+  }
+}
+
+/*********************************************************
+   Heuristic 3*X2 + X1 - (3*O2 + O1) from the view of player p,
+   where a line only counts if the other player has no piece
+   on it and a line of three is not counted at all
+*/
+int heuristic( int p, int bb[10] )
+{
+  int x2=0,x1=0,o2=0,o1=0;
+  int l,k,x,o;
+  for( l = 0; l < 8; l++ ) {
+    x = o = 0;
+    for( k = 0; k < 3; k++ ) {
+      if( bb[lines[l][k]] == p ) {
+        x++;
+      }
+      else if( bb[lines[l][k]] == !p ) {
+        o++;
+      }
+    }
+    if( o == 0 ) {
+      if( x == 2 ) x2++;
+      if( x == 1 ) x1++;
+    }
+    else if( x == 0 ) {
+      if( o == 2 ) o2++;
+      if( o == 1 ) o1++;
+    }
+  }
+  return( 3*x2 + x1 - ( 3*o2 + o1 ));
+}
+
+/*********************************************************
+   Mask of the empty cells where player p would complete a line
+*/
+int threats( int p, int bb[10] )
+{
+  int mask=0;
+  int c;
+  for( c = 1; c <= 9; c++ ) {
+    if( bb[c] == EMPTY ) {
+      bb[c] = p;
+      if( gamewon( p,bb )) {
+        mask |= 1 << ( c - 1 );
+      }
+      bb[c] = EMPTY;
+    }
+  }
+  return( mask );
+}
+
+/*********************************************************
+   Next number from a fixed-seed splitmix64 generator, so that
+   the hash keys are the same every time the tables are built
+*/
+uint64_t next_key( void )
+{
+  static uint64_t state = 0x9E3779B97F4A7C15ULL;
+  uint64_t z = ( state += 0x9E3779B97F4A7C15ULL );
+  z = ( z ^ ( z >> 30 )) * 0xBF58476D1CE4E5B9ULL;
+  z = ( z ^ ( z >> 27 )) * 0x94D049BB133111EBULL;
+  return( z ^ ( z >> 31 ));
+}
+
+/*********************************************************
+   Print the next nine hash keys, for cells or sub-boards 1 to 9
+*/
+void print_keys( char *indent )
+{
+  int c;
+  printf("%s{ 0",indent);
+  for( c = 1; c <= 9; c++ ) {
+    if( c % 3 == 1 ) {
+      printf(",\n%s  ",indent);
+    }
+    else {
+      printf(", ");
+    }
+    printf("0x%016llxULL",( unsigned long long )next_key());
+  }
+  printf(" }");
+}
+
+/*********************************************************
+   Print the body of one array initialiser
+*/
+void print_values( int values[], int n, int per_line )
+{
+  int i;
+  printf("{");
+  for( i = 0; i < n; i++ ) {
+    if( i % per_line == 0 ) {
+      printf("\n ");
+    }
+    printf(" %d%s",values[i],( i < n-1 ) ? "," : "");
+  }
+  printf("\n}");
+}
+
+/*********************************************************
+   Print one table as a C array definition
+*/
+void print_table( char *decl, int values[], int n, int per_line )
+{
+  printf("%s = ",decl);
+  print_values( values,n,per_line );
+  printf(";\n\n");
+}
+
+/*********************************************************/
+int main( void )
+{
+  static int ternary[512];
+  static int score[NUM_PATTERNS];
+  static int flags[NUM_PATTERNS];
+  static int threat[2][NUM_PATTERNS];
+  int bb[10];
+  int mask,c,i;
+
+  for( mask = 0; mask < 512; mask++ ) {
+    int weight = 1;
+    for( c = 0; c < 9; c++ ) {
+      if( mask & ( 1 << c )) {
+        ternary[mask] += weight;
+      }
+      weight *= 3;
+    }
+  }
+
+  for( i = 0; i < NUM_PATTERNS; i++ ) {
+    decode( i,bb );
+    score[i] = heuristic( 0,bb );
+    flags[i] = ( gamewon( 0,bb ) ? PATTERN_WON(0) : 0 )
+             | ( gamewon( 1,bb ) ? PATTERN_WON(1) : 0 )
+             | ( full_board( bb ) ? PATTERN_FULL : 0 );
+    threat[0][i] = threats( 0,bb );
+    threat[1][i] = threats( 1,bb );
+  }
+
+  printf("/* Generated by mktables - do not edit */\n");
+  printf("#include \"tables.h\"\n\n");
+  print_table("const uint16_t ternary[512]",ternary,512,12);
+  print_table("const int8_t pattern_score[NUM_PATTERNS]",score,NUM_PATTERNS,16);
+  print_table("const uint8_t pattern_flags[NUM_PATTERNS]",flags,NUM_PATTERNS,16);
+  printf("const uint16_t pattern_threat[2][NUM_PATTERNS] = {\n");
+  print_values( threat[0],NUM_PATTERNS,12 );
+  printf(",\n");
+  print_values( threat[1],NUM_PATTERNS,12 );
+  printf("\n};\n\n");
+
+  printf("const uint64_t zobrist[2][10][10] = {\n");
+  for( i = 0; i < 2; i++ ) {
+    printf("  {\n    { 0 }");
+    for( c = 1; c <= 9; c++ ) {
+      printf(",\n");
+      print_keys("    ");
+    }
+    printf("\n  }%s\n",( i == 0 ) ? "," : "");
+  }
+  printf("};\n\n");
+  printf("const uint64_t zobrist_board[10] =\n");
+  print_keys("  ");
+  printf(";\n");
+
+  return 0;
+}
@@ -0,0 +1,420 @@
+/*********************************************************
+ *  perft.c
+ *  Nine-Board Tic-Tac-Toe Move Path Counter
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Counts the sequences of exactly N legal moves from a position,
+ *  as "perft" does for chess, along with how many of them end in
+ *  a win or a draw on their last move. A game stops as soon as it
+ *  is won or drawn, just as make_move in game.c decides, so no
+ *  sequence continues past a finished game. The counts are made
+ *  with the bitboard pos_make and pos_unmake the search uses, on
+ *  as many threads as asked for, and with -c they are made again
+ *  with make_move from game.c and compared, so a change to either
+ *  can be checked against the other, or with -t against the known
+ *  counts in perft.txt.
+ *
+ *  A position is written as in positions.txt, or as 0 for the
+ *  start of the game, where the first move may go anywhere.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "common.h"
+#include "game.h"
+#include "bitboard.h"
+#include "search.h"
+
+#define MAX_MOVE   81
+#define MAX_TASKS  ( 81 * 9 )
+#define SPLIT      2  // plies played out before the work is shared among threads
+
+typedef struct {
+  long nodes;  // sequences of exactly the given number of moves
+  long wins;   // ... whose last move won the game
+  long draws;  // ... whose last move sent the next player to a full board
+} perft_count;
+
+// A position read from a line, with the moves played so far held as in
+// servt, where move[0] is the sub-board of the first move. If move[0] is 0
+// the first move has not been made and may go in any sub-board.
+typedef struct {
+  int move[MAX_MOVE+1];
+  int m;        // index of the last move made
+} perft_position;
+
+// The work shared among the threads is the positions SPLIT moves on from
+// the root, or fewer if the game ended before then.
+typedef struct {
+  int move[SPLIT+1];  // sub-board, then the cells played from the root
+  int length;
+  perft_count count;
+} perft_task;
+
+perft_position root;
+perft_task tasks[MAX_TASKS];
+int num_tasks;
+int next_task;
+int perft_depth;
+
+pthread_t workers[MAX_THREADS];
+
+/*********************************************************//*
+   Print usage information and exit
+*/
+void usage( char argv0[] )
+{
+  printf("Usage: %s\n",argv0);
+  printf("       [-d depth]\n");    // count to each depth up to this one
+  printf("       [-j threads]\n");  // number of threads
+  printf("       [-c]\n");          // check the counts with make_move from game.c
+  printf("       [-t file]\n");     // check against the counts in a file instead
+  printf("       [positions]\n");   // positions to count from, 0 for the start
+  exit(1);
+}
+
+/*********************************************************//*
+   Read a position from a string of digits, returning FALSE
+   if it does not hold one or the game is already over
+*/
+int read_position( char *s, perft_position *r )
+{
+  int board[10][10];
+  int p=0;
+
+  if( s[0] < '0' || s[0] > '9' ) {
+    return( FALSE );
+  }
+  r->move[0] = *s++ - '0';
+  r->m = 0;
+  if( r->move[0] == 0 ) {
+    return( *s < '1' || *s > '9' );
+  }
+  reset_board( board );
+  for( ; *s >= '1' && *s <= '9' && r->m < MAX_MOVE; s++ ) {
+    r->move[++r->m] = *s - '0';
+    if( make_move( p,r->m,r->move,board ) != STILL_PLAYING ) {
+      return( FALSE );
+    }
+    p = !p;
+  }
+  return( TRUE );
+}
+
+/*********************************************************//*
+   Set up a position at the root
+*/
+void setup_position( perft_position *r, position *p )
+{
+  int m;
+  pos_reset( p );
+  for( m = 1; m <= r->m; m++ ) {
+    pos_make( p,( m+1 ) % 2,r->move[m-1],r->move[m] );
+  }
+}
+
+/*********************************************************//*
+   Count the sequences of depth moves with player to move in
+   sub-board b, using the bitboard position
+*/
+void perft( position *p, int b, int player, int depth, perft_count *count )
+{
+  int empty = pos_empty( p,b );
+  int c, status;
+
+  for( c = 1; c <= 9; c++ ) {
+    if( !( empty & CELL_BIT(c) )) {
+      continue;
+    }
+    status = pos_make( p,player,b,c );
+    if( depth == 1 ) {
+      count->nodes++;
+      if( status == WIN ) {
+        count->wins++;
+      }
+      else if( status == DRAW ) {
+        count->draws++;
+      }
+    }
+    else if( status == STILL_PLAYING ) {
+      perft( p,c,!player,depth-1,count );
+    }
+    pos_unmake( p,player,b,c );
+  }
+}
+
+/*********************************************************//*
+   Make the list of positions SPLIT moves on from the root
+*/
+void add_tasks( position *p, int move[], int length, int player )
+{
+  int b = move[length];
+  int empty = pos_empty( p,b );
+  int c, status;
+
+  if( length == SPLIT || length == perft_depth ) {
+    memcpy( tasks[num_tasks].move, move, sizeof( tasks[0].move ));
+    tasks[num_tasks].length = length;
+    num_tasks++;
+    return;
+  }
+  for( c = 1; c <= 9; c++ ) {
+    if( empty & CELL_BIT(c) ) {
+      move[length+1] = c;
+      status = pos_make( p,player,b,c );
+      if( status == STILL_PLAYING || length+1 == SPLIT || length+1 == perft_depth ) {
+        add_tasks( p,move,length+1,!player );
+      }
+      pos_unmake( p,player,b,c );
+    }
+  }
+}
+
+/*********************************************************//*
+   Entry point of a worker thread, which counts from each task
+   in turn until there are none left
+*/
+void *perft_worker( void *arg )
+{
+  position p;
+  int k, m, player, status;
+
+  while(( k = __atomic_fetch_add( &next_task, 1, __ATOMIC_RELAXED )) < num_tasks ) {
+    perft_task *task = &tasks[k];
+    setup_position( &root, &p );
+    player = root.m % 2;
+    status = STILL_PLAYING;
+    for( m = 1; m <= task->length; m++ ) {
+      status = pos_make( &p,player,task->move[m-1],task->move[m] );
+      player = !player;
+    }
+    memset( &task->count, 0, sizeof( task->count ));
+    if( task->length == perft_depth ) {
+      task->count.nodes = 1;
+      task->count.wins  = ( status == WIN );
+      task->count.draws = ( status == DRAW );
+    }
+    else if( status == STILL_PLAYING ) {
+      perft( &p,task->move[task->length],player,perft_depth-task->length,&task->count );
+    }
+  }
+  return( NULL );
+}
+
+/*********************************************************//*
+   Count from the root to the given depth on the given number of threads
+*/
+void perft_root( int depth, int threads, perft_count *count )
+{
+  position p;
+  int move[SPLIT+1];
+  int b, k;
+
+  // From the start, the first move is in whichever sub-board the first
+  // player chooses, so each of them is a root of its own.
+  setup_position( &root,&p );
+  perft_depth = depth;
+  num_tasks = 0;
+  next_task = 0;
+  for( b = 1; b <= 9; b++ ) {
+    if( root.move[0] == 0 || b == root.move[root.m] ) {
+      move[0] = b;
+      add_tasks( &p,move,0,root.m % 2 );
+    }
+  }
+
+  for( k = 1; k < threads; k++ ) {
+    if( pthread_create( &workers[k], NULL, perft_worker, NULL ) != 0 ) {
+      threads = k;
+    }
+  }
+  perft_worker( NULL );
+  for( k = 1; k < threads; k++ ) {
+    pthread_join( workers[k], NULL );
+  }
+
+  memset( count, 0, sizeof( *count ));
+  for( k = 0; k < num_tasks; k++ ) {
+    count->nodes += tasks[k].count.nodes;
+    count->wins  += tasks[k].count.wins;
+    count->draws += tasks[k].count.draws;
+  }
+}
+
+/*********************************************************//*
+   Count the sequences of depth moves after move m in the same way,
+   using make_move from game.c, and taking each move back by hand
+*/
+void perft_game( int board[10][10], int move[], int m, int player, int depth, perft_count *count )
+{
+  int c, status;
+
+  for( c = 1; c <= 9; c++ ) {
+    if( board[move[m]][c] != EMPTY ) {
+      continue;
+    }
+    move[m+1] = c;
+    status = make_move( player,m+1,move,board );
+    if( depth == 1 ) {
+      count->nodes++;
+      if( status == WIN ) {
+        count->wins++;
+      }
+      else if( status == DRAW ) {
+        count->draws++;
+      }
+    }
+    else if( status == STILL_PLAYING ) {
+      perft_game( board,move,m+1,!player,depth-1,count );
+    }
+    board[move[m]][c] = EMPTY;
+  }
+}
+
+/*********************************************************//*
+   Count from the root with make_move, on one thread
+*/
+void perft_game_root( int depth, perft_count *count )
+{
+  int board[10][10];
+  int move[MAX_MOVE+2];
+  int m, b;
+
+  memset( count, 0, sizeof( *count ));
+  memcpy( move, root.move, sizeof( root.move ));
+  reset_board( board );
+  for( m = 1; m <= root.m; m++ ) {
+    board[move[m-1]][move[m]] = ( m+1 ) % 2;
+  }
+  if( root.move[0] != 0 ) {
+    perft_game( board,move,root.m,root.m % 2,depth,count );
+    return;
+  }
+  for( b = 1; b <= 9; b++ ) {
+    move[0] = b;
+    perft_game( board,move,0,0,depth,count );
+  }
+}
+
+/*********************************************************//*
+   Count from the root, print the result and check it against make_move
+   or the expected count if asked to, returning FALSE if it is wrong
+*/
+int run( char *name, int depth, int threads, int cross_check, perft_count *expected )
+{
+  perft_count count, other;
+  long long start = clock_usec();
+  int ok = TRUE;
+
+  perft_root( depth,threads,&count );
+  long long usec = clock_usec() - start;
+  printf("%-20s depth %2d  nodes %12ld  wins %11ld  draws %10ld  %8.1f msec  %6.1f M/s",
+         name, depth, count.nodes, count.wins, count.draws, usec / 1000.0,
+         usec ? count.nodes / ( double )usec : 0.0 );
+  if( cross_check ) {
+    perft_game_root( depth,&other );
+    expected = &other;
+  }
+  if( expected != NULL ) {
+    ok = (  count.nodes == expected->nodes && count.wins == expected->wins
+         && count.draws == expected->draws );
+    printf("  %s", ok ? "ok" : "WRONG");
+    if( !ok ) {
+      printf(" (expected %ld %ld %ld)", expected->nodes, expected->wins, expected->draws );
+    }
+  }
+  printf("\n");
+  return( ok );
+}
+
+/*********************************************************/
+int main( int argc, char *argv[] )
+{
+  char *test_file = NULL;
+  int depth = 6;
+  int threads = 1;
+  int cross_check = FALSE;
+  int errors = 0;
+  int i=1, d;
+
+  while( i < argc && argv[i][0] == '-' ) {
+    if( strcmp( argv[i], "-d" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      depth = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-j" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      threads = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-t" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      test_file = argv[i+1];
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-c" ) == 0 ) {
+      cross_check = TRUE;
+      i++;
+    }
+    else {
+      usage( argv[0] );
+    }
+  }
+  if( depth < 1 || depth > MAX_MOVE || threads < 1 || threads > MAX_THREADS ) {
+    usage( argv[0] );
+  }
+
+  // Each line of the test file is a position, a depth and the counts
+  // expected there, and anything after a # is a comment.
+  if( test_file != NULL ) {
+    char line[256], name[100];
+    perft_count expected;
+    FILE *fp = fopen( test_file, "r" );
+    if( fp == NULL ) {
+      perror( test_file );
+      exit(1);
+    }
+    while( fgets( line, sizeof( line ), fp ) != NULL ) {
+      if( sscanf( line, "%99s %d %ld %ld %ld", name, &d, &expected.nodes,
+                  &expected.wins, &expected.draws ) != 5 || name[0] == '#' ) {
+        continue;
+      }
+      if( !read_position( name, &root ) || d < 1 || d > MAX_MOVE ) {
+        printf("%s: bad position %s\n", test_file, name );
+        errors++;
+        continue;
+      }
+      errors += !run( name, d, threads, cross_check, &expected );
+    }
+    fclose( fp );
+  }
+  else {
+    if( i == argc ) {
+      usage( argv[0] );
+    }
+    for( ; i < argc; i++ ) {
+      if( !read_position( argv[i], &root )) {
+        printf("bad position %s\n", argv[i] );
+        errors++;
+        continue;
+      }
+      for( d = 1; d <= depth; d++ ) {
+        errors += !run( argv[i], d, threads, cross_check, NULL );
+      }
+    }
+  }
+  if( errors ) {
+    printf("%d errors\n", errors );
+  }
+  return( errors != 0 );
+}
@@ -0,0 +1,415 @@
+/*********************************************************
+ *  proof.c
+ *  Nine-Board Tic-Tac-Toe Proof-Number Search
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Much of this game is forcing play: a player keeps sending the
+ *  other into sub-boards where they have to block, until they run
+ *  out of safe replies. Alpha-beta only sees the end of such a line
+ *  once its depth reaches it, but a proof-number search looks for
+ *  the win directly, following whichever line looks easiest to
+ *  prove however deep it goes. This runs the depth-first version,
+ *  df-pn, on its own thread next to the main search, trying in turn
+ *  to prove a win for the player to move and a win for the opponent.
+ *
+ *  Proof and disproof numbers are kept in a fixed-size table, one
+ *  for each engine. When it fills up, the entries for the smallest
+ *  subtrees are thrown away, as they are the cheapest to work out
+ *  again.
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "bitboard.h"
+#include "tables.h"
+#include "engine.h"
+#include "search.h"
+#include "proof.h"
+
+#define PN_INF       (1u << 28)  // proof or disproof number of a decided position
+#define PN_WAYS      4           // entries in each bucket of the table
+#define PN_BUDGET    10000       // nodes given to each attacker in the first round
+#define PN_ATTACKER  0x9E3779B97F4A7C15ULL  // XORed into keys when O is the attacker
+
+typedef struct pn_entry {
+  uint64_t key;
+  uint32_t pn;     // how many leaves must still be proven to show the attacker wins
+  uint32_t dn;     // ... or disproven to show they cannot
+  uint32_t work;   // nodes expanded below this position, which decides what to keep
+  uint32_t used;   // TRUE if the entry holds a position
+} pn_entry;
+
+/*********************************************************//*
+   Allocate the proof search's node table, using at most the given number of megabytes
+*/
+void proof_init( proof_state *p, int megabytes )
+{
+  uint64_t buckets = 1;
+  while (buckets * 2 * PN_WAYS * sizeof(pn_entry) <= (uint64_t)megabytes << 20) {
+    buckets *= 2;
+  }
+
+  proof_free(p);
+  p->table = calloc(buckets * PN_WAYS, sizeof(pn_entry));
+  if (p->table == NULL) {
+    perror("cannot allocate proof table ");
+    exit(1);
+  }
+  p->mask = buckets - 1;
+  p->capacity = buckets * PN_WAYS;
+  p->count = 0;
+}
+
+/*********************************************************//*
+   Release the node table
+*/
+void proof_free( proof_state *p )
+{
+  free(p->table);
+  p->table = NULL;
+}
+
+/*********************************************************//*
+   Key of a position for the current attacker, with player to move in board
+*/
+static uint64_t pn_key( proof_state *p, int board )
+{
+  uint64_t key = p->pos.hash ^ zobrist_board[board];
+  return p->attacker ? key ^ PN_ATTACKER : key;
+}
+
+/*********************************************************//*
+   Find a position in the table, returning NULL if it is not there
+*/
+static pn_entry *pn_lookup( proof_state *p, uint64_t key )
+{
+  pn_entry *bucket = &p->table[(key & p->mask) * PN_WAYS];
+  int k;
+  for (k = 0; k < PN_WAYS; ++k) {
+    if (bucket[k].used && bucket[k].key == key) {
+      return &bucket[k];
+    }
+  }
+  return NULL;
+}
+
+/*********************************************************//*
+   Throw away the entries for the smallest subtrees until the table is half empty
+*/
+static void pn_collect( proof_state *p )
+{
+  // Rather than sort the entries by their work, we sweep the table with a limit that doubles
+  // each time, which removes the smallest subtrees first in a few passes.
+  uint32_t limit = 2;
+  long i;
+  while (p->count > p->capacity / 2) {
+    for (i = 0; i < p->capacity; ++i) {
+      if (p->table[i].used && p->table[i].work < limit) {
+        p->table[i].used = FALSE;
+        p->count--;
+      }
+    }
+    limit *= 2;
+  }
+  p->gcs++;
+}
+
+/*********************************************************//*
+   Store the numbers for a position, adding to the work already done below it
+*/
+static void pn_store( proof_state *p, uint64_t key, uint32_t pn, uint32_t dn, uint32_t work )
+{
+  pn_entry *entry = pn_lookup(p, key);
+  if (entry == NULL) {
+    if (p->count >= p->capacity - p->capacity / 4) {
+      pn_collect(p);
+    }
+
+    // A new position takes a free entry in its bucket, or else the one with the least work.
+    pn_entry *bucket = &p->table[(key & p->mask) * PN_WAYS];
+    int k;
+    entry = &bucket[0];
+    for (k = 0; k < PN_WAYS; ++k) {
+      if (!bucket[k].used) {
+        entry = &bucket[k];
+        break;
+      }
+      if (bucket[k].work < entry->work) {
+        entry = &bucket[k];
+      }
+    }
+    if (!entry->used) {
+      p->count++;
+    }
+    entry->key = key;
+    entry->work = 0;
+    entry->used = TRUE;
+  }
+  entry->pn = pn;
+  entry->dn = dn;
+  entry->work = entry->work + work < PN_INF ? entry->work + work : PN_INF;
+}
+
+/*********************************************************//*
+   Proof and disproof numbers of the position after current_player plays cell c
+*/
+static void child_numbers( proof_state *p, int current_board, int current_player, int c, uint32_t *pn, uint32_t *dn )
+{
+  int status = pos_make(&p->pos, current_player, current_board, c);
+  int next = !current_player;
+
+  // A completed line decides the game for the player who made it, and being sent to a full
+  // board is a draw, which is never a win for the attacker. If the player sent to board c can
+  // complete a line there, that is as good as done, and is decided without a search.
+  int winner = -1;
+  if (status == WIN) {
+    winner = current_player;
+  } else if (status == DRAW) {
+    winner = EMPTY;
+  } else if (p->pos.threat[next][c]) {
+    winner = next;
+  }
+
+  if (winner == p->attacker) {
+    *pn = 0;
+    *dn = PN_INF;
+  } else if (winner != -1) {
+    *pn = PN_INF;
+    *dn = 0;
+  } else {
+    pn_entry *entry = pn_lookup(p, pn_key(p, c));
+    if (entry != NULL) {
+      *pn = entry->pn;
+      *dn = entry->dn;
+    } else {
+
+      // A position that has not been searched yet is guessed to be as hard to prove as the
+      // number of moves the defender would have to answer.
+      int moves = pop_count[pos_empty(&p->pos, c)];
+      *pn = next == p->attacker ? 1 : moves;
+      *dn = next == p->attacker ? moves : 1;
+    }
+  }
+  pos_unmake(&p->pos, current_player, current_board, c);
+}
+
+/*********************************************************//*
+   Depth-first proof-number search below one position, until its proof or disproof number
+   reaches the threshold given for it
+*/
+static void mid( engine *e, int current_board, int current_player, uint32_t th_pn, uint32_t th_dn,
+                 uint32_t *out_pn, uint32_t *out_dn )
+{
+  proof_state *p = &e->proof;
+
+  // At a node where the attacker is to move, one proven child is enough to prove it, so its
+  // proof number is the smallest of the children's and its disproof number is their sum. At
+  // the defender's nodes it is the other way around.
+  int or_node = current_player == p->attacker;
+  int empty = pos_empty(&p->pos, current_board);
+  long start = p->nodes;
+  uint32_t pn, dn;
+  int c;
+
+  p->nodes++;
+  while (TRUE) {
+    int best = 0;
+    uint32_t best_value = PN_INF + 1;
+    uint32_t second_value = PN_INF;
+    uint32_t best_pn = 0, best_dn = 0;
+    uint64_t sum = 0;
+    uint32_t min = PN_INF;
+
+    for (c = 1; c <= 9; ++c) {
+      if (!(empty & CELL_BIT(c))) {
+        continue;
+      }
+      uint32_t cpn, cdn;
+      child_numbers(p, current_board, current_player, c, &cpn, &cdn);
+
+      // We follow the child that is easiest to prove at an attacker's node, or to disprove at
+      // a defender's, and keep the next best value to know when to come back from it.
+      uint32_t value = or_node ? cpn : cdn;
+      sum += or_node ? cdn : cpn;
+      if (value < min) {
+        min = value;
+      }
+      if (value < best_value) {
+        second_value = best_value;
+        best_value = value;
+        best = c;
+        best_pn = cpn;
+        best_dn = cdn;
+      } else if (value < second_value) {
+        second_value = value;
+      }
+    }
+    if (sum > PN_INF) {
+      sum = PN_INF;
+    }
+    pn = or_node ? min : (uint32_t)sum;
+    dn = or_node ? (uint32_t)sum : min;
+
+    if (pn >= th_pn || dn >= th_dn || pn == 0 || dn == 0
+        || p->quit || search_stopped(e) || p->nodes >= p->node_budget) {
+      break;
+    }
+
+    // The child is searched until it is no longer the best, or the thresholds of this node are
+    // reached, whichever comes first.
+    uint32_t child_pn, child_dn;
+    if (or_node) {
+      child_pn = th_pn < second_value + 1 ? th_pn : second_value + 1;
+      child_dn = th_dn - dn + best_dn;
+    } else {
+      child_dn = th_dn < second_value + 1 ? th_dn : second_value + 1;
+      child_pn = th_pn - pn + best_pn;
+    }
+    pos_make(&p->pos, current_player, current_board, best);
+    mid(e, best, !current_player, child_pn, child_dn, &best_pn, &best_dn);
+    pos_unmake(&p->pos, current_player, current_board, best);
+  }
+
+  pn_store(p, pn_key(p, current_board), pn, dn, (uint32_t)(p->nodes - start));
+  *out_pn = pn;
+  *out_dn = dn;
+}
+
+/*********************************************************//*
+   Find a child of the root proven to win for the attacker, or return 0
+*/
+static int winning_move( proof_state *p )
+{
+  int empty = pos_empty(&p->pos, p->root_board);
+  int c;
+  for (c = 1; c <= 9; ++c) {
+    uint32_t pn, dn;
+    if (empty & CELL_BIT(c)) {
+      child_numbers(p, p->root_board, p->root_player, c, &pn, &dn);
+      if (pn == 0) {
+        return c;
+      }
+    }
+  }
+  return 0;
+}
+
+/*********************************************************//*
+   Entry point of the proof thread
+*/
+static void *proof_thread( void *arg )
+{
+  engine *e = arg;
+  proof_state *p = &e->proof;
+
+  // We take turns looking for a win for each player, giving each search twice as many nodes
+  // every round, so that neither one can hold up the other for long. What one round finds is
+  // kept in the table for the next.
+  long budget = PN_BUDGET;
+  int k;
+  while (!p->quit && !search_stopped(e) && !(p->decided[0] && p->decided[1])) {
+    for (k = 0; k < 2; ++k) {
+      int a = k == 0 ? p->root_player : !p->root_player;
+      if (p->decided[a]) {
+        continue;
+      }
+      uint32_t pn, dn;
+      p->attacker = a;
+      p->node_budget = p->nodes + budget;
+      mid(e, p->root_board, p->root_player, PN_INF, PN_INF, &pn, &dn);
+      if (pn == 0) {
+        p->proven[a] = WIN;
+        p->decided[a] = TRUE;
+        p->decided[!a] = TRUE;
+
+        // Once a win is proven for us there is nothing left for the main search to find. The
+        // winning move is picked out now, before its entry can be collected.
+        if (a == p->root_player) {
+          p->move = winning_move(p);
+          set_search_stop(e, TRUE);
+        }
+      } else if (dn == 0) {
+        p->decided[a] = TRUE;
+      }
+      if (p->quit || search_stopped(e)) {
+        break;
+      }
+    }
+    budget *= 2;
+  }
+  return NULL;
+}
+
+/*********************************************************//*
+   Start looking for a forced win or loss from the engine's position on a thread of its own
+*/
+void proof_start( engine *e, int current_board, int current_player )
+{
+  proof_state *p = &e->proof;
+
+  if (p->table == NULL || p->running) {
+    return;
+  }
+  p->pos = e->pos;
+  p->root_board = current_board;
+  p->root_player = current_player;
+  p->proven[0] = p->proven[1] = FALSE;
+  p->move = 0;
+  p->decided[0] = p->decided[1] = FALSE;
+  p->quit = FALSE;
+  if (pthread_create(&p->handle, NULL, proof_thread, e) == 0) {
+    p->running = TRUE;
+  }
+}
+
+/*********************************************************//*
+   Stop the proof search and return the move to play instead of this_move
+*/
+int proof_stop( engine *e, int this_move, int *result )
+{
+  proof_state *p = &e->proof;
+  int empty = pos_empty(&p->pos, p->root_board);
+  int c;
+
+  *result = STILL_PLAYING;
+  if (!p->running) {
+    return this_move;
+  }
+  p->quit = TRUE;
+  pthread_join(p->handle, NULL);
+  p->running = FALSE;
+
+  // With a proven win, we play the move that wins.
+  if (p->proven[p->root_player] == WIN && p->move > 0) {
+    *result = WIN;
+    return p->move;
+  }
+
+  // Otherwise, if the move chosen by the main search is proven to lose, we play instead the
+  // move that the opponent's proof search found hardest to prove a win against.
+  p->attacker = !p->root_player;
+  if (p->proven[p->attacker] == WIN) {
+    *result = LOSS;
+  }
+  uint32_t pn, dn;
+  if (this_move > 0 && (empty & CELL_BIT(this_move))) {
+    child_numbers(p, p->root_board, p->root_player, this_move, &pn, &dn);
+    if (pn == 0) {
+      uint32_t hardest = 0;
+      for (c = 1; c <= 9; ++c) {
+        if (empty & CELL_BIT(c)) {
+          child_numbers(p, p->root_board, p->root_player, c, &pn, &dn);
+          if (pn > hardest) {
+            hardest = pn;
+            this_move = c;
+          }
+        }
+      }
+    }
+  }
+  return this_move;
+}
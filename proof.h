@@ -0,0 +1,52 @@
+/*********************************************************
+ *  proof.h
+ *  Nine-Board Tic-Tac-Toe Proof-Number Search
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#ifndef PROOF_H
+#define PROOF_H
+
+#include <pthread.h>
+
+#include "bitboard.h"
+
+// The proof search's node table and thread, one for each engine
+typedef struct {
+  struct pn_entry *table;
+  uint64_t mask;          // number of buckets - 1
+  long count;             // entries in use
+  long capacity;
+  long nodes;             // nodes expanded by the proof search since proof_init
+  long gcs;               // number of times the node table has been garbage collected
+
+  position pos;           // the proof search's own copy of the position
+  int root_board;
+  int root_player;
+  int attacker;           // the player a win is being looked for
+  long node_budget;       // nodes at which the current round ends
+  int proven[2];          // WIN once a win for that player is proven
+  int decided[2];         // TRUE once that player's search is finished
+  int move;               // a move proven to win for the player to move
+  volatile int quit;
+  pthread_t handle;
+  int running;            // TRUE while the thread is running
+} proof_state;
+
+struct engine;
+
+// Allocate the proof search's node table, using at most the given number of megabytes
+void proof_init(proof_state *p, int megabytes);
+
+// Release the node table
+void proof_free(proof_state *p);
+
+// Start looking for a forced win or loss from the engine's position on a thread of its own
+void proof_start(struct engine *e, int current_board, int current_player);
+
+// Stop the proof search and return the move to play instead of this_move, which is a
+// winning move if a forced win was found, or one that is not a forced loss if this_move
+// is. *result is set to WIN or LOSS if the position itself was proven, else STILL_PLAYING.
+int proof_stop(struct engine *e, int this_move, int *result);
+
+#endif
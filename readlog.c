@@ -0,0 +1,220 @@
+/*********************************************************
+ *  readlog.c
+ *  Nine-Board Tic-Tac-Toe Game Log Reader
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Reads the game logs written by servt and selfplay with -l, a
+ *  game at a time, and prints the games that pass its filters, or
+ *  with -c only counts them, or with -w copies them to another log.
+ *  With no files it reads stdin.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+#include "gamelog.h"
+
+/*********************************************************//*
+   Print usage information and exit
+*/
+void usage( char argv0[] )
+{
+  printf("Usage: %s\n",argv0);
+  printf("       [-c]\n");              // count the games rather than print them
+  printf("       [-t]\n");              // print the time of each move
+  printf("       [-r x|o|d]\n");        // games X won, O won or drawn
+  printf("       [-C cause]\n");        // games ended by triple, illegal_move, timeout or full_board
+  printf("       [-p player]\n");       // games with a player whose name contains this
+  printf("       [-m moves]\n");        // games that start with these moves, as in positions.txt
+  printf("       [-w game_log]\n");     // add the games to another log
+  printf("       [file ...]\n");
+  exit(1);
+}
+
+char *cause_names[] = { "triple", "illegal_move", "timeout", "full_board" };
+int   cause_codes[] = { TRIPLE, ILLEGAL_MOVE, TIMEOUT, FULL_BOARD };
+
+/*********************************************************//*
+   Name of a cause, as in the messages servt sends
+*/
+char *cause_name( int cause )
+{
+  int k;
+  for( k = 0; k < 4; k++ ) {
+    if( cause_codes[k] == cause ) {
+      return( cause_names[k] );
+    }
+  }
+  return( "unknown" );
+}
+
+/*********************************************************//*
+   Print a game on one line, with its times on the next if asked
+*/
+void print_game( FILE *fp, game_entry *g, int times )
+{
+  int m;
+  for( m = 0; m <= g->length; m++ ) {
+    fputc( '0' + g->move[m], fp );
+  }
+  fprintf( fp, "  X %s  O %s  ", g->players[0], g->players[1] );
+  if( g->result == DRAW ) {
+    fprintf( fp, "draw (%s)\n", cause_name( g->cause ));
+  }
+  else {
+    fprintf( fp, "Player %c wins (%s)\n", sb[g->result == WIN ? 0 : 1], cause_name( g->cause ));
+  }
+  if( times && g->timed ) {
+    fprintf( fp, "  msec" );
+    for( m = 1; m <= g->length; m++ ) {
+      fprintf( fp, " %.1f", g->usec[m] / 1000.0 );
+    }
+    fprintf( fp, "\n" );
+  }
+}
+
+/*********************************************************/
+int main( int argc, char *argv[] )
+{
+  gamelog *log, *out = NULL;
+  game_entry g;
+  char *player = NULL, *prefix = NULL;
+  int count = FALSE, times = FALSE;
+  int result = -1, cause = -1;  // -1 for any, as ILLEGAL_MOVE is 0
+  long games = 0, total = 0, moves = 0;
+  long results[3] = {0,0,0};  // X wins, O wins, draws
+  long causes[4] = {0,0,0,0};
+  struct timespec start, fin;
+  int i=1, k, m, first_file;
+
+  while( i < argc && argv[i][0] == '-' && argv[i][1] != '\0' ) {
+    if( strcmp( argv[i], "-c" ) == 0 ) {
+      count = TRUE;
+      i++;
+    }
+    else if( strcmp( argv[i], "-t" ) == 0 ) {
+      times = TRUE;
+      i++;
+    }
+    else if( strcmp( argv[i], "-r" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      result = argv[i+1][0] == 'x' ? WIN : argv[i+1][0] == 'o' ? LOSS
+             : argv[i+1][0] == 'd' ? DRAW : -1;
+      if( result < 0 ) {
+        usage( argv[0] );
+      }
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-C" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      for( k = 0; k < 4 && strcmp( argv[i+1], cause_names[k] ) != 0; k++ )
+        ;
+      if( k == 4 ) {
+        usage( argv[0] );
+      }
+      cause = cause_codes[k];
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-p" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      player = argv[i+1];
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-m" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      prefix = argv[i+1];
+      if( strspn( prefix, "0123456789" ) != strlen( prefix )) {
+        usage( argv[0] );
+      }
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-w" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      out = gamelog_append( argv[i+1] );
+      if( out == NULL ) {
+        exit(1);
+      }
+      i += 2;
+    }
+    else {
+      usage( argv[0] );
+    }
+  }
+
+  clock_gettime( CLOCK_MONOTONIC, &start );
+  first_file = i;
+  do {
+    char *path = i < argc ? argv[i] : "-";
+    log = gamelog_open( path );
+    if( log == NULL ) {
+      exit(1);
+    }
+    while( gamelog_read( log, &g )) {
+      total++;
+      if(   ( result >= 0 && g.result != result )
+         || ( cause >= 0 && g.cause != cause )
+         || ( player != NULL && strstr( g.players[0], player ) == NULL
+                             && strstr( g.players[1], player ) == NULL )) {
+        continue;
+      }
+      if( prefix != NULL ) {
+        for( m = 0; prefix[m] != '\0' && m <= g.length && prefix[m] == '0' + g.move[m]; m++ )
+          ;
+        if( prefix[m] != '\0' ) {
+          continue;
+        }
+      }
+
+      games++;
+      moves += g.length;
+      results[g.result == WIN ? 0 : g.result == LOSS ? 1 : 2]++;
+      for( k = 0; k < 4; k++ ) {
+        if( cause_codes[k] == g.cause ) {
+          causes[k]++;
+        }
+      }
+      if( out != NULL && !gamelog_write( out, &g )) {
+        perror( "game log" );
+        exit(1);
+      }
+      if( !count && out == NULL ) {
+        print_game( stdout, &g, times );
+      }
+    }
+    gamelog_close( log );
+    i++;
+  } while( i < argc );
+  clock_gettime( CLOCK_MONOTONIC, &fin );
+  gamelog_close( out );
+
+  if( count ) {
+    double seconds = ( fin.tv_sec - start.tv_sec ) + ( fin.tv_nsec - start.tv_nsec ) / 1e9;
+    printf("games %ld  X wins %ld  O wins %ld  draws %ld", games, results[0], results[1], results[2] );
+    if( games > 0 ) {
+      printf("  X score %.1f%%  moves per game %.1f",
+             100.0 * ( results[0] + 0.5 * results[2] ) / games, ( double )moves / games );
+    }
+    printf("\n");
+    for( k = 0; k < 4; k++ ) {
+      printf("%s %ld%s", cause_names[k], causes[k], k < 3 ? "  " : "\n" );
+    }
+    fprintf( stderr, "%ld games read from %d file%s in %.3f sec, %.2f M games/sec\n",
+             total, argc - first_file > 1 ? argc - first_file : 1,
+             argc - first_file > 1 ? "s" : "", seconds,
+             seconds > 0 ? total / seconds / 1e6 : 0.0 );
+  }
+  return 0;
+}
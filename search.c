@@ -0,0 +1,747 @@
+/*********************************************************
+ *  search.c
+ *  Nine-Board Tic-Tac-Toe Alpha-Beta Search
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#include <pthread.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "common.h"
+#include "bitboard.h"
+#include "tables.h"
+#include "ttable.h"
+#include "search.h"
+#include "solver.h"
+#include "proof.h"
+
+// Order in which moves are tried: the best move stored in the transposition table,
+// then the two killer moves for this ply, then the rest by their history score, and
+// last of all any move that lets the opponent complete a line straight away.
+#define ORDER_HASH     (1 << 30)
+#define ORDER_KILLER   (1 << 29)
+#define HISTORY_MAX    (1 << 28)
+#define ORDER_GIFT     (-1)
+
+// Half-width of the window the root is first searched with, around an earlier score
+#define ASPIRATION     2
+
+// Most forced moves the quiescence search will follow past the depth of the search
+#define QUIESCE_PLIES  8
+
+/*********************************************************//*
+   Read the monotonic clock in microseconds
+*/
+long long clock_usec()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( ts.tv_sec*1000000LL + ts.tv_nsec/1000 );
+}
+
+/*********************************************************//*
+   Milliseconds since the engine's search started
+*/
+int elapsed_msec( engine *e )
+{
+  return(( int )(( clock_usec() - e->search_start ) / 1000 ));
+}
+
+
+/*********************************************************//*
+   Choose a move by iterative deepening, searching one level deeper each time until the
+   time allowed for this move runs out
+*/
+int setup_search( engine *e, int current_board, int current_player )
+{
+
+  // Rather than always searching to a fixed depth, which is wasteful late in the game when the
+  // search finishes almost instantly and risky early on when it does not, we search to depth 1,
+  // then depth 2, and so on. Each search is much quicker than the next, so repeating the
+  // shallower ones costs very little, and we always have the move from the deepest search
+  // that was completed to fall back on.
+  //
+  // With more than one thread we use "Lazy SMP": every thread runs its own iterative deepening
+  // on its own copy of the position, and the only thing they share is the transposition table.
+  // The helper threads fill the table with results the main thread would otherwise have had to
+  // search for itself, and since each thread orders its moves by its own killers and history,
+  // and half of them run one depth ahead, they tend to explore different parts of the tree.
+
+  // There is no point searching deeper than the number of empty cells left on the grid.
+  int max_depth = 0;
+  int b, c, k;
+  for (b = 1; b <= 9; ++b) {
+    max_depth += pop_count[pos_empty(&e->pos, b)];
+  }
+
+#ifdef SEARCH_STATS
+  memset(&e->last_stats, 0, sizeof(e->last_stats));
+#endif
+  e->search_proof = STILL_PLAYING;
+
+  // Near the end of the game the tree left is small enough to be searched right to the end, so
+  // rather than guess with the heuristic we hand the position to the exact solver. It may use
+  // half of the time up to the soft limit, and if it cannot prove the result by then we search
+  // as usual with the time left over. The solver knows nothing of depth or node limits, so it
+  // is left out of any search that has one.
+  if (max_depth <= e->endgame_empties && e->depth_limit == 0 && e->node_limit == 0) {
+    int score;
+    int move = solve_root(e, current_board, current_player, e->soft_limit / 2, &score);
+    if (move > 0) {
+      e->nodes = e->solver.nodes;
+      e->cutoffs = 0;
+      e->first_move_cutoffs = 0;
+      e->researches = 0;
+      // A solved result is as good as a proof, and is reported on the same scale as the
+      // search's scores, however soon the win comes.
+      e->search_depth = max_depth;
+      e->search_score = score > 0 ? 100 : score < 0 ? -100 : 0;
+      e->search_proof = score > 0 ? WIN : score < 0 ? LOSS : STILL_PLAYING;
+      e->pv_line[0] = move;
+      e->pv_count = 1;
+      return move;
+    }
+  }
+
+  if (e->depth_limit > 0 && e->depth_limit < max_depth) {
+    max_depth = e->depth_limit;
+  }
+
+  // Each engine keeps its threads from one search to the next, since their history scores are
+  // worth keeping, and only makes more of them when it is asked to search with more than before.
+  int count = e->num_threads < 1 ? 1 : e->num_threads > MAX_THREADS ? MAX_THREADS : e->num_threads;
+  if (count > e->allocated_threads) {
+    search_thread *more = realloc(e->threads, count * sizeof(search_thread));
+    if (more == NULL) {
+      count = e->allocated_threads;
+    } else {
+      memset(more + e->allocated_threads, 0, (count - e->allocated_threads) * sizeof(search_thread));
+      e->threads = more;
+      e->allocated_threads = count;
+    }
+  }
+  for (k = 0; k < count; ++k) {
+    search_thread *t = &e->threads[k];
+    t->e = e;
+    t->id = k;
+    t->pos = e->pos;
+    t->current_board = current_board;
+    t->current_player = current_player;
+    t->max_depth = max_depth;
+
+    // The killer moves belong to positions two plies back by now, so we start them afresh, and the
+    // history scores are halved so that what was learned on earlier moves slowly fades away.
+    memset(t->killers, 0, sizeof(t->killers));
+    for (b = 1; b <= 9; ++b) {
+      for (c = 1; c <= 9; ++c) {
+        t->history[b][c] /= 2;
+      }
+    }
+    t->nodes = 0;
+    t->cutoffs = 0;
+    t->first_move_cutoffs = 0;
+    t->researches = 0;
+    memset(&t->stats, 0, sizeof(t->stats));
+    t->last_score[0] = 0;
+    t->last_score[1] = 0;
+    t->best_move = -1;
+    t->best_depth = 0;
+    t->best_score = 0;
+    t->pv_count = 0;
+  }
+  tt_new_search(&e->tt);
+
+  // The main thread completes the depth 1 search on its own before any helper is started. It
+  // visits no more than 9 nodes, so it always finishes before the clock is first checked and we
+  // are sure to have a legal move to play, however little time there is.
+  search_thread *main_thread = &e->threads[0];
+  iterative_deepening(main_thread, 1, 1);
+
+  if (max_depth > 1 && main_thread->best_score < 100 && main_thread->best_score > -100) {
+    if (e->proof_search) {
+      proof_start(e, current_board, current_player);
+    }
+    for (k = 1; k < count; ++k) {
+      if (pthread_create(&e->threads[k].handle, NULL, helper_thread, &e->threads[k]) != 0) {
+        count = k;
+      }
+    }
+    iterative_deepening(main_thread, 2, max_depth);
+
+    // Once the main thread has finished, the helpers are told to stop and we wait for them.
+    set_search_stop(e, TRUE);
+    for (k = 1; k < count; ++k) {
+      pthread_join(e->threads[k].handle, NULL);
+    }
+  }
+
+  // We play the move from the deepest search any thread completed, preferring the main thread's
+  // when there is a tie, and add up the statistics of all the threads.
+  search_thread *best = main_thread;
+  e->nodes = 0;
+  e->cutoffs = 0;
+  e->first_move_cutoffs = 0;
+  e->researches = 0;
+  for (k = 0; k < count; ++k) {
+    search_thread *t = &e->threads[k];
+    if (t->best_depth > best->best_depth) {
+      best = t;
+    }
+    e->nodes += t->nodes;
+    e->cutoffs += t->cutoffs;
+    e->first_move_cutoffs += t->first_move_cutoffs;
+    e->researches += t->researches;
+#ifdef SEARCH_STATS
+    if (k == 0) {
+      e->last_stats = t->stats;  // the iterations recorded are the main thread's
+    } else {
+      e->last_stats.leaf_evals += t->stats.leaf_evals;
+      e->last_stats.terminal_hits += t->stats.terminal_hits;
+      e->last_stats.hash_probes += t->stats.hash_probes;
+      e->last_stats.hash_hits += t->stats.hash_hits;
+      e->last_stats.hash_cutoffs += t->stats.hash_cutoffs;
+      e->last_stats.quiesce_nodes += t->stats.quiesce_nodes;
+      e->last_stats.gift_prunes += t->stats.gift_prunes;
+      for (c = 0; c < 9; ++c) {
+        e->last_stats.cutoffs_at[c] += t->stats.cutoffs_at[c];
+      }
+    }
+#endif
+  }
+  e->search_depth = best->best_depth;
+  e->search_score = best->best_score;
+  e->pv_count = best->pv_count;
+  memcpy(e->pv_line, best->pv_line, e->pv_count * sizeof(int));
+
+  // A win or loss proven by the proof search overrides the choice of the heuristic search.
+  int this_move = proof_stop(e, best->best_move, &e->search_proof);
+  if (this_move != best->best_move) {
+    e->pv_line[0] = this_move;
+    e->pv_count = 1;
+  }
+  return this_move;
+}
+
+/*********************************************************//*
+   Entry point of a helper thread, which searches until told to stop
+*/
+void *helper_thread( void *arg )
+{
+  search_thread *t = arg;
+  iterative_deepening(t, 1 + t->id % 2, t->max_depth);
+  return NULL;
+}
+
+/*********************************************************//*
+   Search one thread's copy of the position from first_depth to last_depth, keeping the
+   result of the deepest search it completes
+*/
+void iterative_deepening( search_thread *t, int first_depth, int last_depth )
+{
+  int score = 0;
+  int depth;
+
+  for (depth = first_depth; depth <= last_depth; ++depth) {
+
+    // The score rarely changes much between searches, so we start with a narrow window around
+    // the previous score, which lets more of the tree be pruned. Searches of odd and even depth
+    // end on different players' moves and their scores tend to alternate, so the window is
+    // centred on the last search with the same parity. If the true score turns out to be
+    // outside the window, that side of it is widened and the search is repeated.
+    int alpha = -200;
+    int beta = 200;
+    int delta = ASPIRATION;
+    if (depth > 2) {
+      alpha = t->last_score[depth % 2] - delta;
+      beta = t->last_score[depth % 2] + delta;
+    }
+
+    int search_move;
+    while (TRUE) {
+      search_move = search_root(t, t->current_board, depth, alpha, beta, t->current_player, &score);
+      if (search_stopped(t->e)) {
+        break;
+      }
+      delta *= 4;
+      if (score <= alpha) {
+        alpha = score - delta < -200 ? -200 : score - delta;
+      } else if (score >= beta) {
+        beta = score + delta > 200 ? 200 : score + delta;
+      } else {
+        break;
+      }
+      t->researches++;
+    }
+    if (search_stopped(t->e)) {
+      break;
+    }
+    t->last_score[depth % 2] = score;
+
+    // We keep the move, score and principal variation of the deepest search completed.
+    t->best_move = search_move;
+    t->best_depth = depth;
+    if (t->id == 0) {
+      STAT_DEPTH(t, depth, elapsed_msec(t->e));
+    }
+    t->best_score = score;
+    t->pv_count = t->pv_length[0];
+    memcpy(t->pv_line, t->pv[0], t->pv_count * sizeof(int));
+
+    // If a win or loss has been found there is nothing to gain by searching any deeper.
+    if (score >= 100 || score <= -100) {
+      break;
+    }
+
+    // The next search takes several times longer than this one, so the main thread does not
+    // start it unless there is a good chance of it finishing in time. Helpers just carry on
+    // until the main thread stops them.
+    if (t->id == 0 && elapsed_msec(t->e) >= t->e->soft_limit) {
+      break;
+    }
+  }
+}
+
+/*********************************************************//*
+   Print the depth, score and principal variation of the last search
+*/
+void print_search( engine *e, FILE *fp )
+{
+  int k;
+  fprintf(fp, "depth %d score %d nodes %ld msec %d", e->search_depth, e->search_score, e->nodes, elapsed_msec(e));
+  if (e->search_proof == WIN || e->search_proof == LOSS) {
+    fprintf(fp, " proven %s", e->search_proof == WIN ? "win" : "loss");
+  }
+  fprintf(fp, " pv");
+  for (k = 0; k < e->pv_count; ++k) {
+    fprintf(fp, " %d", e->pv_line[k]);
+  }
+  fprintf(fp, "\n");
+}
+
+/*********************************************************//*
+   This is the first iteration of the alpha-beta search, returning the position to play in
+*/
+int search_root( search_thread *t, int current_board, int depth, int alpha, int beta, int current_player, int *score )
+{
+
+  // The window is chosen by setup_search. For a full search, alpha = -infinity and
+  // beta = infinity, and since the maximum heuristic value for any node is 100,
+  // using -200 and 200 will suffice.
+  int original_alpha = alpha;
+
+  // The first iteration of our alpha-beta search is done here so we can determine the actual move
+  // we want to make, as our alpha_beta_search function only returns the value of alpha not the move
+  // which provided this value.
+  int this_move = -1;
+
+  // The legal moves are the empty cells of the current board. The best move from the previous
+  // iteration was stored in the transposition table, so it is tried first.
+  uint64_t key = t->pos.hash ^ zobrist_board[current_board];
+  tt_entry entry;
+  int found = tt_probe(&t->e->tt, key, &entry);
+  STAT_INC(t, hash_probes);
+  if (found) {
+    STAT_INC(t, hash_hits);
+  }
+  int moves[9];
+  int num_moves = order_moves(t, current_board, current_player, 0, found ? entry.move : 0, moves);
+  t->root_depth = depth;
+  t->pv_length[0] = 0;
+
+  int n;
+  for (n = 0; n < num_moves; ++n) {
+    int i = moves[n];
+
+    // For the chosen position, we assign this move on the board.
+    pos_make(&t->pos, current_player, current_board, i);
+
+    // We now call our alpha_beta_search function to recursively check all children nodes,
+    // either until its terminal or the depth is reached. The depth is decreased by 1 and
+    // the new board will be the position we are playing on the current board, being i.
+    // Note since we are using the negamax variant, our value of alpha is -beta
+    // and our value of beta is -alpha. Also, it is considered from the perspective
+    // of the opponent, so we pass in !current_player as the current player.
+    // As in alpha_beta_search, only the first move gets the full window.
+    int search_result = search_child(t, i, depth - 1, alpha, beta, !current_player, n == 0);
+
+    // After attaining our results from the search, we can undo our move on this position.
+    pos_unmake(&t->pos, current_player, current_board, i);
+
+    // If we ran out of time part way through, the result of this search can't be trusted.
+    if (search_stopped(t->e)) {
+      return -1;
+    }
+
+    // Here we are taking the max of our current alpha and the return value
+    // of the alpha beta search, assigning this as alpha.
+    if (search_result > alpha) {
+      alpha = search_result;
+
+      // If the alpha beta search returned a larger alpha than our previous alpha,
+      // we not only update alpha but also update the move to be chosen.
+      this_move = i;
+      update_pv(t, 0, i);
+    }
+
+    // With a narrowed window the root can fail high, in which case there is no need to look
+    // at the other moves before the window is opened up.
+    if (alpha >= beta) {
+      break;
+    }
+  }
+
+  // We return the chosen move after the search is completed, along with its value, which
+  // is also kept in the transposition table. If no move got above the bottom of the window,
+  // the value is only an upper bound and there is no move to return.
+  tt_store(&t->e->tt, key, depth, alpha >= beta ? BOUND_LOWER : alpha > original_alpha ? BOUND_EXACT : BOUND_UPPER,
+           alpha, this_move > 0 ? this_move : 0);
+  *score = alpha;
+  return this_move;
+}
+
+/*********************************************************//*
+   Negamax formulation of alpha-beta search
+*/
+int alpha_beta_search( search_thread *t, int current_board, int depth, int alpha, int beta, int current_player )
+{
+
+  // The principal variation from this node is empty until a move raises alpha.
+  int ply = t->root_depth - depth;
+  t->pv_length[ply] = ply;
+
+  // Every so often we check the clock, and if we have gone past the time allowed for this
+  // move, or searched as many nodes as we may, we give up on the search. Once search_stop
+  // is set, every level returns straight away and the value returned no longer matters.
+  if ((++t->nodes & 1023) == 0
+  && (elapsed_msec(t->e) >= t->e->hard_limit || (t->e->node_limit > 0 && t->nodes >= t->e->node_limit))) {
+    set_search_stop(t->e, TRUE);
+  }
+  if (search_stopped(t->e)) {
+    return 0;
+  }
+
+  // Before we continue with the search, we first check if the current node is terminal.
+  // This is the case if the opponent got 3 in a row in the previous move, in which case we
+  // return -100, or if the board we have been sent to is full so that a move can no longer be
+  // made, where 0 is returned. Both were already worked out when the previous move was made.
+  int is_terminal_node = evaluate_terminal(t, current_player);
+  if (is_terminal_node != -1) {
+    STAT_INC(t, terminal_hits);
+    return is_terminal_node;
+  }
+
+  // If the depth of the search equals 0, we don't want to search any deeper, and instead return
+  // the heuristic value for this node. We use the function 3*X2 + X1 - (3*O2 + O1) for each board,
+  // with the sum of all such values being our total heuristic value, which is kept up to date
+  // as moves are made. Before trusting it, quiesce checks that the position is quiet, meaning
+  // nobody is about to win whatever happens.
+  if (depth == 0) {
+    if (t->e->quiescence) {
+      return quiesce(t, current_board, current_player, QUIESCE_PLIES);
+    }
+    return evaluate_heuristic(t, current_player);
+  }
+
+  // If we can complete a line on this board, no other move can score higher, so there is no
+  // need to look any further. Searching this node would find the same, as the win is only one
+  // move away, and the cells that win were worked out when this board last changed.
+  int wins = t->pos.threat[current_player][current_board];
+  if (wins) {
+    int i = __builtin_ctz(wins) + 1;
+    t->pv_length[ply + 1] = ply + 1;
+    update_pv(t, ply, i);
+    STAT_INC(t, terminal_hits);
+    return 100 > alpha ? 100 : alpha;
+  }
+
+  // The same position is often reached through different orders of moves, so we look it up
+  // in the transposition table, keyed by the pieces on the board and the board we have been
+  // sent to. If it has already been searched at least as deep, the stored score either
+  // answers the question outright or may be enough to show this node is outside the window.
+  uint64_t key = t->pos.hash ^ zobrist_board[current_board];
+  tt_entry entry;
+  int found = tt_probe(&t->e->tt, key, &entry);
+  STAT_INC(t, hash_probes);
+  if (found) {
+    STAT_INC(t, hash_hits);
+  }
+  if (found && entry.depth >= depth) {
+    if (entry.bound == BOUND_EXACT
+    || (entry.bound == BOUND_LOWER && entry.score >= beta)
+    || (entry.bound == BOUND_UPPER && entry.score <= alpha)) {
+      STAT_INC(t, hash_cutoffs);
+      return entry.score;
+    }
+  }
+  int original_alpha = alpha;
+  int best_move = 0;
+
+  // Alpha-beta prunes the most when the best move is searched first, so rather than trying the
+  // empty cells of the current board in order, we start with the ones most likely to be best.
+  int moves[9];
+  int num_moves = order_moves(t, current_board, current_player, ply, found ? entry.move : 0, moves);
+
+  // Now for each child of the current node, we can begin our alpha-beta search
+  // using the negamax formulation.
+  int n;
+  for (n = 0; n < num_moves; ++n) {
+    int i = moves[n];
+
+    // For the chosen position, we assign this move on the board.
+    pos_make(&t->pos, current_player, current_board, i);
+
+    // A move that sends the opponent to a board where they can complete a line is a gift: with
+    // at least one more move to search they would find the win, so we know its value is -100
+    // without searching it. At depth 1 the opponent's reply is not searched, and unless the
+    // quiescence search is there to find the win the heuristic decides instead, so the move is
+    // then searched as usual to give the same result.
+    // Otherwise this is where we recursively call alpha_beta_search. We store the negative of
+    // the final result in a variable, which we will later compare against our current alpha.
+    // Like before, the new board is the same as the position we have chosen,
+    // the depth is decreased by 1, alpha is -beta and beta is -alpha, and
+    // we are playing from the perspective of the opponent, so player is !current_player.
+    // Once the first move has been searched, the rest are expected to be worse, so
+    // search_child first checks this with a cheaper null window search.
+    int search_result;
+    if ((depth >= 2 || t->e->quiescence) && t->pos.threat[!current_player][i]) {
+      STAT_INC(t, gift_prunes);
+      search_result = -100;
+    } else {
+      search_result = search_child(t, i, depth - 1, alpha, beta, !current_player, n == 0);
+    }
+
+    // After attaining our results from the search, we can undo our move on this position.
+    pos_unmake(&t->pos, current_player, current_board, i);
+
+    // A search that ran out of time leaves nothing worth storing.
+    if (search_stopped(t->e)) {
+      return 0;
+    }
+
+    // Here we are taking the max of our current alpha and the return value
+    // of the alpha beta search, assigning this as alpha.
+    if (search_result > alpha) {
+      alpha = search_result;
+      best_move = i;
+      update_pv(t, ply, i);
+    }
+
+    // This is the pruning stage of the alpha-beta search, and is what allows the depth
+    // to be much greater than what would be possible using regular minimax.
+    // All we do is compare alpha and beta, and if alpha is greater or equal,
+    // we can prune this section of the tree and return alpha, which is only a lower bound
+    // on the value of this node.
+    // The move that caused the cutoff is remembered as a killer move for this ply, and its
+    // history score goes up, more so the deeper the search it cut off.
+    if (alpha >= beta) {
+        t->cutoffs++;
+        STAT_CUTOFF(t, n);
+        if (n == 0) {
+          t->first_move_cutoffs++;
+        }
+        if (t->killers[ply][0] != i) {
+          t->killers[ply][1] = t->killers[ply][0];
+          t->killers[ply][0] = i;
+        }
+        t->history[current_board][i] += depth * depth;
+        if (t->history[current_board][i] > HISTORY_MAX) {
+          int b, c;
+          for (b = 1; b <= 9; ++b) {
+            for (c = 1; c <= 9; ++c) {
+              t->history[b][c] /= 2;
+            }
+          }
+        }
+        tt_store(&t->e->tt, key, depth, BOUND_LOWER, alpha, best_move);
+        return alpha;
+    }
+  }
+
+  // Finally we return alpha after searching all child nodes. If none of them raised alpha,
+  // all we know is that the value of this node is no more than alpha.
+  tt_store(&t->e->tt, key, depth, alpha > original_alpha ? BOUND_EXACT : BOUND_UPPER, alpha, best_move);
+  return alpha;
+
+}
+
+/*********************************************************//*
+   Principal variation search of a child node, returning its value from the parent's view
+*/
+int search_child( search_thread *t, int current_board, int depth, int alpha, int beta, int current_player, int first )
+{
+
+  // The first move is searched with the full window, as it is expected to be the best.
+  if (first) {
+    return -alpha_beta_search(t, current_board, depth, -beta, -alpha, current_player);
+  }
+
+  // For every other move we only need to show that it is no better than alpha, which a search
+  // with the null window (alpha, alpha + 1) does far more cheaply. Only if the move turns out
+  // to be better after all is it searched again with the full window to find its real value.
+  int search_result = -alpha_beta_search(t, current_board, depth, -alpha - 1, -alpha, current_player);
+  if (search_result > alpha && search_result < beta && !search_stopped(t->e)) {
+    t->researches++;
+    search_result = -alpha_beta_search(t, current_board, depth, -beta, -alpha, current_player);
+  }
+  return search_result;
+}
+
+/*********************************************************//*
+   Record that move followed by the best line from the next ply as the best line from ply
+*/
+void update_pv( search_thread *t, int ply, int move )
+{
+  int k;
+  t->pv[ply][ply] = move;
+  for (k = ply + 1; k < t->pv_length[ply + 1]; ++k) {
+    t->pv[ply][k] = t->pv[ply + 1][k];
+  }
+  t->pv_length[ply] = t->pv_length[ply + 1] > ply + 1 ? t->pv_length[ply + 1] : ply + 1;
+}
+
+/*********************************************************//*
+   Put the legal moves of the current board in the order they should be searched
+*/
+int order_moves( search_thread *t, int current_board, int current_player, int ply, int hash_move, int moves[9] )
+{
+  int scores[9];
+  int num_moves = 0;
+
+  // Each empty cell of the current board is given a score, with the move stored in the
+  // transposition table first, the killer moves for this ply next, and the rest in order
+  // of how often they have caused cutoffs before. Moves that hand the opponent a win on the
+  // board they are sent to come last. Our own piece can only take away their winning cell
+  // when it is played in the board it sends them to.
+  const uint16_t *threat = t->pos.threat[!current_player];
+  int empty = pos_empty(&t->pos, current_board);
+  while (empty) {
+    int i = __builtin_ctz(empty) + 1;
+    empty &= empty - 1;
+
+    int score = 0;
+    if (t->e->move_ordering) {
+      if (threat[i] & ~(i == current_board ? CELL_BIT(i) : 0)) {
+        score = ORDER_GIFT;
+      } else if (i == hash_move) {
+        score = ORDER_HASH;
+      } else if (i == t->killers[ply][0]) {
+        score = ORDER_KILLER + 1;
+      } else if (i == t->killers[ply][1]) {
+        score = ORDER_KILLER;
+      } else {
+        score = t->history[current_board][i];
+      }
+    }
+
+    // With at most 9 moves, an insertion sort is all that is needed. Moves with equal
+    // scores stay in the order of their cells.
+    int k = num_moves++;
+    while (k > 0 && scores[k - 1] < score) {
+      scores[k] = scores[k - 1];
+      moves[k] = moves[k - 1];
+      k--;
+    }
+    scores[k] = score;
+    moves[k] = i;
+  }
+
+  return num_moves;
+}
+
+/*********************************************************//*
+   Evaluating if the current node is terminal
+*/
+int evaluate_terminal( search_thread *t, int current_player )
+{
+
+  // Whenever a move is made, the pattern tables tell us if it completed 3 in a row on the
+  // board it was played in, and we also check if the board it sends the next player to is
+  // full, so all we need to do here is read off the status of the last move.
+
+  // If the opponent won with their last move this is a losing position, so we return -100.
+  if (t->pos.status == WIN) {
+    return -100;
+  }
+
+  // If we have been sent to a full board the game is a tie, so we return 0.
+  if (t->pos.status == DRAW) {
+    return 0;
+  }
+
+  // Otherwise the node is not terminal, and we return -1.
+  return -1;
+
+}
+
+/*********************************************************//*
+   At the depth of the search, follow only forced moves before evaluating the node
+*/
+int quiesce( search_thread *t, int current_board, int current_player, int budget )
+{
+
+  // The heuristic can be badly wrong about a position where a win is one move away, and the
+  // next ply of a full search would have found it. Here we only resolve what is forced, which
+  // costs a few nodes at most. If we can complete a line on this board, we have won.
+  if (t->pos.threat[current_player][current_board]) {
+    STAT_INC(t, terminal_hits);
+    return 100;
+  }
+
+  // Otherwise every move that sends the opponent to a board where they can complete a line
+  // loses straight away. A move that sends them to a full board is a draw. The rest are safe.
+  int empty = pos_empty(&t->pos, current_board);
+  int safe = 0;
+  int draw = FALSE;
+  int i;
+  for (i = 1; i <= 9; ++i) {
+    if (!(empty & CELL_BIT(i))) {
+      continue;
+    }
+    if (i == current_board ? pop_count[empty] == 1 : pos_full(&t->pos, i)) {
+      draw = TRUE;
+    } else if (!(t->pos.threat[!current_player][i] & ~(i == current_board ? CELL_BIT(i) : 0))) {
+      safe |= CELL_BIT(i);
+    }
+  }
+
+  // With no safe move, the best we can do is a draw, if there is one, or else we lose. With
+  // exactly one safe move and no draw, that move is forced, so we play it and look again from
+  // the opponent's side, as long as the budget of extra plies lasts.
+  if (safe == 0) {
+    STAT_INC(t, terminal_hits);
+    return draw ? 0 : -100;
+  }
+  if (!draw && (safe & (safe - 1)) == 0 && budget > 0) {
+    i = __builtin_ctz(safe) + 1;
+    t->nodes++;
+    STAT_INC(t, quiesce_nodes);
+    pos_make(&t->pos, current_player, current_board, i);
+    int value = -quiesce(t, i, !current_player, budget - 1);
+    pos_unmake(&t->pos, current_player, current_board, i);
+    return value;
+  }
+
+  // Otherwise the position is quiet enough for the heuristic.
+  return evaluate_heuristic(t, current_player);
+}
+
+/*********************************************************//*
+   If the depth of the alpha-beta search is 0, evaluate the heuristic value of this node
+*/
+int evaluate_heuristic( search_thread *t, int current_player )
+{
+
+  // The heuristic function 3*X2 + X1 - (3*O2 + O1) has been worked out in advance by
+  // mktables for every state a board can be in, counting X2, X1, O2 and O1 over all
+  // rows, columns and diagonals. Each move changes only one board, so its value is
+  // updated when the move is made and the running total over all boards is kept.
+  // The total is from the view of X, so it is negated when the current player is O.
+  int heuristic_function = t->pos.total;
+  STAT_INC(t, leaf_evals);
+
+  return current_player == 0 ? heuristic_function : -heuristic_function;
+}
+
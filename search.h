@@ -0,0 +1,87 @@
+/*********************************************************
+ *  search.h
+ *  Nine-Board Tic-Tac-Toe Alpha-Beta Search
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#ifndef SEARCH_H
+#define SEARCH_H
+
+#include <pthread.h>
+#include <stdio.h>
+
+#include "bitboard.h"
+#include "engine.h"
+#include "stats.h"
+
+// Everything one search thread needs of its own. The threads of an engine share
+// nothing but its transposition table and the flag telling them to stop.
+struct search_thread {
+  engine *e;                    // the engine this thread searches for
+  int id;                       // 0 for the main thread
+  position pos;                 // this thread's copy of the position
+  int current_board;
+  int current_player;
+  int max_depth;
+  int root_depth;               // depth of the current iteration, so ply = root_depth - depth
+  int killers[MAX_PLY][2];      // the last two moves to cause a cutoff at each ply
+  int history[10][10];          // how useful each (board, cell) move has been in cutoffs
+  int pv[MAX_PLY][MAX_PLY];     // pv[ply] holds the best line found from ply onwards
+  int pv_length[MAX_PLY];       // ... which ends just before pv_length[ply]
+  int last_score[2];            // score of the last odd and even depth searches
+  long nodes;
+  long cutoffs;
+  long first_move_cutoffs;
+  long researches;
+  int best_move;                // result of the deepest search this thread completed
+  int best_depth;
+  int best_score;
+  int pv_line[MAX_PLY];
+  int pv_count;
+  search_stats stats;           // only kept up to date when built with SEARCH_STATS
+  pthread_t handle;
+};
+
+// Read the monotonic clock in microseconds
+long long clock_usec();
+
+// Milliseconds since the engine's search started
+int elapsed_msec(engine *e);
+
+// Chooses the position to play in by iterative deepening within the time allowed
+int setup_search(engine *e, int current_board, int current_player);
+
+// Entry point of a helper thread
+void *helper_thread(void *arg);
+
+// Searches one thread's copy of the position to each depth in turn
+void iterative_deepening(search_thread *t, int first_depth, int last_depth);
+
+// Prints the depth, score and principal variation of the last search
+void print_search(engine *e, FILE *fp);
+
+// Used for the first iteration of the alpha-beta search, returns the position to play in
+int search_root(search_thread *t, int current_board, int depth, int alpha, int beta, int current_player, int *score);
+
+// Negamax formulation of alpha-beta search
+int alpha_beta_search(search_thread *t, int current_board, int depth, int alpha, int beta, int current_player);
+
+// Principal variation search of a child node, returning its value from the parent's view
+int search_child(search_thread *t, int current_board, int depth, int alpha, int beta, int current_player, int first);
+
+// Records the best line found from a ply
+void update_pv(search_thread *t, int ply, int move);
+
+// Puts the legal moves in the order they should be searched, returning how many there are
+int order_moves(search_thread *t, int current_board, int current_player, int ply, int hash_move, int moves[9]);
+
+// Follows forced moves at the depth of the search before evaluating the node
+int quiesce(search_thread *t, int current_board, int current_player, int budget);
+
+// Evaluates if the current node is terminal
+int evaluate_terminal(search_thread *t, int current_player);
+
+// Evaluates the heuristic value of a node
+int evaluate_heuristic(search_thread *t, int current_player);
+
+#endif
@@ -0,0 +1,221 @@
+/*********************************************************
+ *  searcht.c
+ *  Nine-Board Tic-Tac-Toe Fixed-Depth Search Test
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Searches each position in a file to a fixed depth and reports
+ *  the nodes visited and how often the first move tried caused
+ *  the cutoff, which shows how well the moves are being ordered.
+ *  With -s it instead gives each position a fixed time, as the
+ *  agent would, and reports how deep the search got, which is the
+ *  way to compare different numbers of threads.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "search.h"
+
+/*********************************************************//*
+   Print usage information and exit
+*/
+void usage( char argv0[] )
+{
+  printf("Usage: %s\n",argv0);
+  printf("       [-d depth]\n");     // depth to search each position to
+  printf("       [-s msec]\n");      // search each position for this long instead
+  printf("       [-j threads]\n");  // number of search threads
+  printf("       [-e empties]\n");  // solve exactly with this many empty cells, with -s only
+  printf("       [-f]\n");           // look for forced wins with proof-number search
+  printf("       [-m megabytes]\n"); // memory for the search tables
+  printf("       [-u]\n");           // leave the moves unordered
+  printf("       [-q]\n");           // stop at the depth, without quiescence
+  printf("       [-v]\n");           // print the principal variation
+  printf("       [positions]\n");    // file of positions, one per line
+  exit(1);
+}
+
+/*********************************************************//*
+   Set up a position from a line of the positions file, returning the
+   sub-board to move in, and the player to move in *to_move,
+   or 0 if the line does not hold a position
+*/
+int read_position( position *pos, char *line, int *to_move )
+{
+  int board_num, p=0;
+  char *s;
+
+  if( line[0] < '1' || line[0] > '9' ) {
+    return( 0 );
+  }
+  pos_reset( pos );
+  board_num = line[0] - '0';
+  for( s = line+1; *s >= '1' && *s <= '9'; s++ ) {
+    if( pos_make( pos, p, board_num, *s - '0' ) != STILL_PLAYING ) {
+      return( 0 );
+    }
+    board_num = *s - '0';
+    p = !p;
+  }
+  *to_move = p;
+  return( board_num );
+}
+
+/*********************************************************/
+int main( int argc, char *argv[] )
+{
+  char *file = "positions.txt";
+  int depth = 8;
+  int msec = 0;
+  int megabytes = 32;
+  int verbose = FALSE;
+  int num_threads = 1;
+  int proof_search = FALSE;
+  int move_ordering = TRUE;
+  int quiescence = TRUE;
+  long total_nodes = 0, total_cutoffs = 0, total_first = 0, total_depth = 0;
+  long long start;
+  char line[256];
+  FILE *fp;
+  engine *e;
+  int i=1, n=0;
+
+  // the ordinary search is what is being measured, unless -e is given
+  int endgame_empties = 0;
+
+  while( i < argc ) {
+    if( strcmp( argv[i], "-d" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      depth = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-s" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      msec = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-f" ) == 0 ) {
+      proof_search = TRUE;
+      i++;
+    }
+    else if( strcmp( argv[i], "-e" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      endgame_empties = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-j" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      num_threads = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-m" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      megabytes = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-u" ) == 0 ) {
+      move_ordering = FALSE;
+      i++;
+    }
+    else if( strcmp( argv[i], "-q" ) == 0 ) {
+      quiescence = FALSE;
+      i++;
+    }
+    else if( strcmp( argv[i], "-v" ) == 0 ) {
+      verbose = TRUE;
+      i++;
+    }
+    else if( argv[i][0] != '-' ) {
+      file = argv[i];
+      i++;
+    }
+    else {
+      usage( argv[0] );
+    }
+  }
+  if(   depth <= 0 || msec < 0 || megabytes <= 0
+     || num_threads < 1 || num_threads > MAX_THREADS ) {
+    usage( argv[0] );
+  }
+
+  fp = fopen( file, "r" );
+  if( fp == NULL ) {
+    perror( file );
+    exit(1);
+  }
+
+  e = engine_new( megabytes );
+  if( e == NULL ) {
+    fprintf( stderr, "out of memory\n" );
+    exit(1);
+  }
+  e->depth_limit = msec ? 0 : depth;
+  e->num_threads = num_threads;
+  e->endgame_empties = endgame_empties;
+  e->proof_search = proof_search;
+  e->move_ordering = move_ordering;
+  e->quiescence = quiescence;
+  start = clock_usec();
+
+  while( fgets( line, sizeof( line ), fp ) != NULL ) {
+    int board_num, to_move, this_move;
+    board_num = read_position( &e->pos, line, &to_move );
+    if( board_num == 0 ) {
+      continue;
+    }
+
+    // every position starts with an empty table, and no time limit
+    // unless one was asked for, in which case it is shared out as
+    // the agent would share out the time for a move
+    tt_clear( &e->tt );
+    e->search_start = clock_usec();
+    set_search_stop( e, FALSE );
+    e->soft_limit = e->hard_limit = 1 << 30;
+    if( msec ) {
+      e->hard_limit = msec;
+      e->soft_limit = msec / 2;
+    }
+    this_move = setup_search( e, board_num, to_move );
+
+    printf("%3d  move %d  depth %2d  nodes %10ld  cutoffs %9ld  first %5.1f%%  re-searches %ld\n",
+           ++n, this_move, e->search_depth, e->nodes, e->cutoffs,
+           e->cutoffs ? 100.0 * e->first_move_cutoffs / e->cutoffs : 0.0, e->researches );
+    if( verbose ) {
+      printf("     ");
+      print_search( e, stdout );
+    }
+    total_depth   += e->search_depth;
+    total_nodes   += e->nodes;
+    total_cutoffs += e->cutoffs;
+    total_first   += e->first_move_cutoffs;
+  }
+  fclose( fp );
+
+  if( msec ) {
+    printf("msec %d  threads %d  positions %d  mean depth %.2f  nodes %ld  (%.1f msec)\n",
+           msec, num_threads, n, n ? ( double )total_depth / n : 0.0, total_nodes,
+           ( clock_usec() - start ) / 1000.0 );
+  }
+  else {
+    printf("depth %d  positions %d  nodes %ld  cutoffs %ld  first %.1f%%  (%.1f msec)\n",
+           depth, n, total_nodes, total_cutoffs,
+           total_cutoffs ? 100.0 * total_first / total_cutoffs : 0.0,
+           ( clock_usec() - start ) / 1000.0 );
+  }
+  engine_free( e );
+  return 0;
+}
@@ -0,0 +1,262 @@
+/*********************************************************
+ *  selfplay.c
+ *  Nine-Board Tic-Tac-Toe Self-Play
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Plays a series of games of the search against itself, or
+ *  against another configuration of itself, in one process, and
+ *  reports how many X won, O won and were drawn. Every game starts
+ *  with a first move chosen at random or given with -m, as servt
+ *  does, and any number of random moves after it, or else with an
+ *  opening read from a file. With the same opening and settings
+ *  the search always plays the same game. With -l every game is
+ *  added to a game log, see gamelog.h, with each side named by
+ *  its settings.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#include "common.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "search.h"
+#include "match.h"
+#include "gamelog.h"
+
+/*********************************************************//*
+   Print usage information and exit
+*/
+void usage( char argv0[] )
+{
+  printf("Usage: %s\n",argv0);
+  printf("       [-n num_games]\n");    // number of games
+  printf("       [-d depth]\n");        // depth both sides search to
+  printf("       [-N nodes]\n");        // nodes both sides may search per move
+  printf("       [-x config]\n");       // settings for X, such as depth=8,noquiesce
+  printf("       [-o config]\n");       // settings for O
+  printf("       [-m board square]\n"); // specify first move of every game
+  printf("       [-r plies]\n");        // random moves after the first
+  printf("       [-f openings]\n");     // file of openings, played in turn
+  printf("       [-H megabytes]\n");    // memory for each side's search tables
+  printf("       [-S seed]\n");         // random seed
+  printf("       [-l game_log]\n");     // add each game to a log
+  printf("       [-v]\n");              // print each game
+  exit(1);
+}
+
+/*********************************************************/
+int main( int argc, char *argv[] )
+{
+  engine_config config[2];
+  engine *engines[2];
+  game_record *openings = NULL;
+  game_record opening, game;
+  char *openings_file = NULL;
+  char *log_file = NULL;
+  gamelog *log = NULL;
+  game_entry entry;
+  int first[2] = {0,0};
+  int num_games = 100;
+  int plies = 0;
+  int megabytes = 2;
+  int verbose = FALSE;
+  int num_openings = 0;
+  int results[3] = {0,0,0};  // X wins, O wins, draws
+  long total_moves = 0;
+  struct timeval tp;
+  long long start;
+  int i=1, k, result, cause;
+
+  gettimeofday( &tp, NULL );
+  srandom(( unsigned int )( tp.tv_usec ));
+
+  config_default( &config[0] );
+  config_default( &config[1] );
+
+  while( i < argc ) {
+    if( strcmp( argv[i], "-n" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      num_games = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-d" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      config[0].depth = config[1].depth = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-N" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      config[0].nodes = config[1].nodes = atol(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-x" ) == 0 || strcmp( argv[i], "-o" ) == 0 ) {
+      if( i+1 >= argc || !config_parse( argv[i+1], &config[argv[i][1] == 'o'] )) {
+        usage( argv[0] );
+      }
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-m" ) == 0 ) {
+      if( i+2 >= argc ) {
+        usage( argv[0] );
+      }
+      first[0] = atoi(argv[i+1]);
+      first[1] = atoi(argv[i+2]);
+      if(   first[0] < 1 || first[0] > 9
+         || first[1] < 1 || first[1] > 9 ) {
+        usage( argv[0] );
+      }
+      i += 3;
+    }
+    else if( strcmp( argv[i], "-r" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      plies = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-f" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      openings_file = argv[i+1];
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-H" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      megabytes = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-S" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      srandom(( unsigned int )atoi(argv[i+1]));
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-l" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      log_file = argv[i+1];
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-v" ) == 0 ) {
+      verbose = TRUE;
+      i++;
+    }
+    else {
+      usage( argv[0] );
+    }
+  }
+  if( num_games < 1 || plies < 0 || plies > 40 || megabytes < 1 ) {
+    usage( argv[0] );
+  }
+
+  if( openings_file != NULL ) {
+    char line[256];
+    FILE *fp = fopen( openings_file, "r" );
+    if( fp == NULL ) {
+      perror( openings_file );
+      exit(1);
+    }
+    openings = malloc( num_games * sizeof( game_record ));
+    while( num_openings < num_games && fgets( line, sizeof( line ), fp ) != NULL ) {
+      if( opening_read( line, &openings[num_openings] )) {
+        num_openings++;
+      }
+    }
+    fclose( fp );
+    if( num_openings == 0 ) {
+      fprintf( stderr, "%s: no openings\n", openings_file );
+      exit(1);
+    }
+  }
+
+  if( log_file != NULL ) {
+    log = gamelog_append( log_file );
+    if( log == NULL ) {
+      exit(1);
+    }
+    // the players are named by their settings, cut short if need be
+    memset( &entry, 0, sizeof( entry ));
+    for( k = 0; k < 2; k++ ) {
+      FILE *fp = fmemopen( entry.players[k], sizeof( entry.players[k] ) - 1, "w" );
+      config_print( fp, &config[k] );
+      fclose( fp );
+    }
+    entry.timed = TRUE;
+  }
+
+  engines[0] = engine_new( megabytes );
+  engines[1] = engine_new( megabytes );
+  if( engines[0] == NULL || engines[1] == NULL ) {
+    fprintf( stderr, "out of memory\n" );
+    exit(1);
+  }
+  start = clock_usec();
+
+  for( k = 0; k < num_games; k++ ) {
+    if( num_openings > 0 ) {
+      opening = openings[k % num_openings];
+    }
+    else {
+      opening_random( &opening, first[0], first[1], plies );
+    }
+    result = play_game( engines, config, &opening, &game, &cause );
+    results[result == WIN ? 0 : result == LOSS ? 1 : 2]++;
+    total_moves += game.length;
+
+    if( log != NULL ) {
+      entry.result = result;
+      entry.cause = cause;
+      entry.length = game.length;
+      memcpy( entry.move, game.move, sizeof( entry.move ));
+      memcpy( entry.usec, game.usec, sizeof( entry.usec ));
+      if( !gamelog_write( log, &entry )) {
+        perror( log_file );
+        exit(1);
+      }
+    }
+
+    if( verbose ) {
+      printf("%4d  ", k+1 );
+      record_print( stdout, &game );
+      if( result == DRAW ) {
+        printf("  draw (full_board)\n");
+      }
+      else {
+        printf("  Player %c wins (%s)\n", sb[result == WIN ? 0 : 1],
+               cause == TRIPLE ? "triple" : "illegal_move");
+      }
+    }
+  }
+
+  double seconds = ( clock_usec() - start ) / 1000000.0;
+  printf("X: ");
+  config_print( stdout, &config[0] );
+  printf("\nO: ");
+  config_print( stdout, &config[1] );
+  printf("\ngames %d  X wins %d  O wins %d  draws %d  X score %.1f%%\n",
+         num_games, results[0], results[1], results[2],
+         100.0 * ( results[0] + 0.5 * results[2] ) / num_games );
+  printf("moves per game %.1f  %.2f sec  %.1f games/sec\n",
+         ( double )total_moves / num_games, seconds,
+         seconds > 0 ? num_games / seconds : 0.0 );
+
+  gamelog_close( log );
+  free( openings );
+  engine_free( engines[0] );
+  engine_free( engines[1] );
+  return 0;
+}
@@ -4,30 +4,154 @@
  *  COMP3411/9414/9814 Artificial Intelligence
  *  Dion Earle, Assignment 3
  */
+#define _GNU_SOURCE
 #include <string.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <sys/time.h>
+#include <time.h>
 #include <sys/socket.h>
 #include <arpa/inet.h>
 #include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <fcntl.h>
+#include <errno.h>
 #include <unistd.h>
 
 #include "common.h"
 #include "game.h"
+#include "gamelog.h"
 
 #define  MAX_MOVE              81
 
 FILE *agent_in[2];
 FILE *agent_out[2];
 int   agent_fd[2];
-int  msec_left[2];
+char  agent_name[2][GAMELOG_MAX_NAME+1];
+long long usec_left[2];
+int   move_usec[MAX_MOVE+1];  // time taken over each move of the game
 int   is_human[2]={FALSE,FALSE};
 
   // allow 30 secons initially, plus 2 seconds for each move
 int seconds_initially = 30;
 int seconds_per_move  =  2;
 
+  // with -c, tell the agents the time left on their clock before each move
+int send_clock = FALSE;
+
+  // with -l, add each game to a game log
+gamelog *game_log = NULL;
+
+/*********************************************************//*
+   Read the monotonic clock in usec, which unlike the time of
+   day never jumps while a move is being timed
+*/
+long long now_usec()
+{
+  struct timespec ts;
+  clock_gettime( CLOCK_MONOTONIC, &ts );
+  return( ts.tv_sec*1000000LL + ts.tv_nsec/1000 );
+}
+
+/*********************************************************//*
+   How long an agent took over each of its moves, from the
+   request being sent to the reply being read, and how much
+   time it had left when each of its games ended
+*/
+typedef struct {
+  long long *think;        // usec taken over each move
+  int moves;
+  int allocated;
+  long long left_total;    // usec left at the end of its games, summed
+  long long left_min;
+  int games;
+} agent_times;
+
+agent_times agent_timing[2];
+
+/*********************************************************//*
+   Record the time an agent took over one move
+*/
+void times_move( agent_times *t, long long usec )
+{
+  if( t->moves == t->allocated ) {
+    int allocated = t->allocated ? 2*t->allocated : 256;
+    long long *think = realloc( t->think, allocated * sizeof( long long ));
+    if( think == NULL ) {
+      return;
+    }
+    t->think = think;
+    t->allocated = allocated;
+  }
+  t->think[t->moves++] = usec;
+}
+
+/*********************************************************//*
+   Record the time an agent had left when one of its games ended
+*/
+void times_game_end( agent_times *t, long long usec )
+{
+  if( t->games == 0 || usec < t->left_min ) {
+    t->left_min = usec;
+  }
+  t->left_total += usec;
+  t->games++;
+}
+
+/*********************************************************//*
+   Add the times recorded for one agent to those of another
+*/
+void times_add( agent_times *t, agent_times *from )
+{
+  int k;
+  for( k = 0; k < from->moves; k++ ) {
+    times_move( t, from->think[k] );
+  }
+  if( from->games > 0 && ( t->games == 0 || from->left_min < t->left_min )) {
+    t->left_min = from->left_min;
+  }
+  t->left_total += from->left_total;
+  t->games += from->games;
+}
+
+int compare_usec( const void *a, const void *b )
+{
+  long long x = *( const long long * )a, y = *( const long long * )b;
+  return(( x > y ) - ( x < y ));
+}
+
+/*********************************************************//*
+   Think time below which a fraction p of the moves were made
+*/
+double percentile_msec( agent_times *t, double p )
+{
+  int k = ( int )( p * t->moves + 0.999999 ) - 1;
+  if( k < 0 ) {
+    k = 0;
+  }
+  return( t->think[k] / 1000.0 );
+}
+
+/*********************************************************//*
+   Print the think times and time left recorded for an agent
+*/
+void times_print( char *name, agent_times *t )
+{
+  if( t->moves == 0 ) {
+    printf("%-12s no moves\n", name );
+    return;
+  }
+  qsort( t->think, t->moves, sizeof( long long ), compare_usec );
+  printf("%-12s moves %5d  think msec p50 %.1f  p90 %.1f  p99 %.1f  max %.1f",
+         name, t->moves, percentile_msec( t,0.5 ), percentile_msec( t,0.9 ),
+         percentile_msec( t,0.99 ), t->think[t->moves-1] / 1000.0 );
+  if( t->games > 0 ) {
+    printf("  left at end msec mean %.1f  min %.1f",
+           t->left_total / 1000.0 / t->games, t->left_min / 1000.0 );
+  }
+  printf("\n");
+}
+
 
 /*********************************************************//*
    Write message to specified player
@@ -52,11 +176,73 @@ void write_all(char *str)
 }
 
 /*********************************************************//*
-   Set up network connection(s)
+   Name an agent by the address it connected from
 */
-void server_init( int port )
+void peer_name( int fd, char *name )
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof( addr );
+  char host[INET_ADDRSTRLEN];
+
+  if(   getpeername( fd, ( struct sockaddr * )&addr, &len ) != 0
+     || inet_ntop( AF_INET, &addr.sin_addr, host, sizeof( host )) == NULL ) {
+    strcpy( name, "agent" );
+    return;
+  }
+  snprintf( name, GAMELOG_MAX_NAME+1, "%s:%d", host, ntohs( addr.sin_port ));
+}
+
+/*********************************************************//*
+   Add a game to the game log, if there is one. The game ended
+   with game_status on move m, made or owed by player.
+*/
+void log_game(
+              char *x_name,
+              char *o_name,
+              int move[],
+              int usec[],
+              int m,
+              int player,
+              int game_status
+             )
 {
-  int i, slen, client, server;
+  game_entry g;
+
+  if( game_log == NULL ) {
+    return;
+  }
+  strncpy( g.players[0], x_name, GAMELOG_MAX_NAME );
+  strncpy( g.players[1], o_name, GAMELOG_MAX_NAME );
+  g.players[0][GAMELOG_MAX_NAME] = g.players[1][GAMELOG_MAX_NAME] = '\0';
+  if( game_status == WIN ) {
+    g.result = player == 0 ? WIN : LOSS;
+    g.cause  = TRIPLE;
+  }
+  else if( game_status == DRAW ) {
+    g.result = DRAW;
+    g.cause  = FULL_BOARD;
+  }
+  else {
+    g.result = player == 0 ? LOSS : WIN;
+    g.cause  = game_status == ILLEGAL_MOVE ? ILLEGAL_MOVE : TIMEOUT;
+  }
+  // a move that came too late, if it came at all, is not part of the game
+  g.length = game_status == TIMEOUT ? m-1 : m;
+  memcpy( g.move, move, ( MAX_MOVE+1 )*sizeof( int ));
+  memcpy( g.usec, usec, ( MAX_MOVE+1 )*sizeof( int ));
+  g.timed = TRUE;
+  if( !gamelog_write( game_log, &g )) {
+    perror( "game log" );
+    exit(1);
+  }
+}
+
+/*********************************************************//*
+   Open the server socket and listen on it
+*/
+int server_listen( int port, int backlog )
+{
+  int slen, server;
 
   struct sockaddr_in servAddr;
 
@@ -86,27 +272,47 @@ void server_init( int port )
   printf("Connecting to port %d\n", ntohs(servAddr.sin_port));
 
   // server listen
-  if(listen(server, 5) != 0) {
+  if(listen(server, backlog) != 0) {
     perror("cannot listen ");
     exit(1);
   }
+  return( server );
+}
+
+/*********************************************************//*
+   Turn off Nagle's algorithm, so each move is sent at once
+*/
+void set_no_delay( int client )
+{
+  int tcp_no_delay = 1;
+  if(setsockopt(client, IPPROTO_TCP, TCP_NODELAY,
+     (char *)&tcp_no_delay, sizeof(tcp_no_delay)) < 0) {
+    perror ("tcpecho: TCP_NODELAY options");
+    exit(1);
+  }
+}
+
+/*********************************************************//*
+   Set up network connection(s)
+*/
+void server_init( int port )
+{
+  int i, client, server;
+
+  server = server_listen( port, 5 );
 
   // accept client connections
   for(i = 0; i < 2; i++) {
     if( !is_human[i] ) {
-      int tcp_no_delay = 1;
       client = accept(server, NULL, NULL);
       if( client < 0 ) {
         perror("cannot accept connection ");
         return exit(1);
       }
-      if(setsockopt(client, IPPROTO_TCP, TCP_NODELAY,
-         (char *)&tcp_no_delay, sizeof(tcp_no_delay)) < 0) {
-        perror ("tcpecho: TCP_NODELAY options");
-        exit(1);
-      }
+      set_no_delay( client );
 
       agent_fd[i]  = client;
+      peer_name( client, agent_name[i] );
       agent_in[i]  = fdopen(client,"w");
       agent_out[i] = fdopen(client,"r");
     }
@@ -149,6 +355,22 @@ int human_step(
   return( make_move( player,m,move,board ));
 }
 
+/*********************************************************//*
+   Write the message asking for move m into buf
+*/
+void move_request( char *buf, int m, int move[] )
+{
+  if ( m == 2 ) { // second move
+    sprintf(buf,"second_move(%d,%d).\n",move[0],move[1]);
+  }
+  else if( m == 3 ) { // third move
+    sprintf(buf,"third_move(%d,%d,%d).\n",move[0],move[1],move[2]);
+  }
+  else {
+    sprintf(buf,"next_move(%d).\n",move[m-1]);
+  }
+}
+
 /*********************************************************//*
    Invite computer player to send next move
 */
@@ -161,41 +383,36 @@ int server_step(
 {
   int game_status;
   struct timeval tv;
-  struct timeval tod_start, tod_fin;
-  int move_msec;
+  long long asked, think;
   int move_scanned;
   fd_set fds;
   int i;
-  if ( m == 2 ) { // second move
-    fprintf(agent_in[player],"second_move(%d,%d).\n",
-            move[0],move[1]);
-  }
-  else if( m == 3 ) { // third move
-    fprintf(agent_in[player],"third_move(%d,%d,%d).\n",
-            move[0],move[1],move[2]);
-  }
-  else {
-    fprintf(agent_in[player],"next_move(%d).\n",move[m-1]);
+  char request[64];
+
+  usec_left[player] += 1000000LL * seconds_per_move;
+  if( send_clock ) {
+    fprintf(agent_in[player],"clock(%d,%d).\n",
+            ( int )( usec_left[player]/1000 ),1000 * seconds_per_move);
   }
+  move_request( request,m,move );
+  fprintf(agent_in[player],"%s",request);
   fflush(agent_in[player]);
 
   FD_ZERO(&fds);
   FD_SET(agent_fd[player], &fds);
 
-  msec_left[player] += 1000 * seconds_per_move;
-
+  // a reply that comes after the clock has run out would lose anyway
   memset(&tv, 0, sizeof(struct timeval));
-  tv.tv_sec = 1 + msec_left[player]/1000;
+  if( usec_left[player] > 0 ) {
+    tv.tv_sec  = usec_left[player] / 1000000;
+    tv.tv_usec = usec_left[player] % 1000000;
+  }
 
-  gettimeofday( &tod_start, NULL );
+  asked = now_usec();
   i = select(agent_fd[player] + 1, &fds, NULL, NULL, &tv);
   if( i > 0 ) {
     move_scanned = fscanf(agent_out[player], "%d", &move[m]);
-    gettimeofday( &tod_fin, NULL );
-    move_msec = 1 + (tod_fin.tv_sec -tod_start.tv_sec )*1000
-                  + (tod_fin.tv_usec-tod_start.tv_usec)/1000;
-    msec_left[player] -= move_msec;
-    if( move_scanned ) {
+    if( move_scanned == 1 ) {
       game_status = make_move( player,m,move,board );
     }
     else {
@@ -205,7 +422,11 @@ int server_step(
   else {
     game_status = TIMEOUT;
   }
-  if(( msec_left[player] < 0 )&&( game_status == STILL_PLAYING) ) {
+  think = now_usec() - asked;
+  usec_left[player] -= think;
+  move_usec[m] = think < 1000000000 ? ( int )think : 1000000000;
+  times_move( &agent_timing[player], think );
+  if(( usec_left[player] < 0 )&&( game_status == STILL_PLAYING) ) {
     game_status = TIMEOUT;
   }
   return( game_status );
@@ -220,7 +441,7 @@ void play_games( int num_games, int move[] )
   int game_status;
   int player, first_player;
   int game;
-  int m;
+  int m, i;
 
   first_player = 0;
 
@@ -230,8 +451,9 @@ void play_games( int num_games, int move[] )
     write_agent( first_player,"start(x).\n");
     write_agent(!first_player,"start(o).\n");
 
-    msec_left[0] = 1000*(seconds_initially - seconds_per_move);
-    msec_left[1] = 1000*(seconds_initially - seconds_per_move);
+    usec_left[0] = 1000000LL*(seconds_initially - seconds_per_move);
+    usec_left[1] = 1000000LL*(seconds_initially - seconds_per_move);
+    memset( move_usec, 0, sizeof( move_usec ));
 
     if( game > 0 || move[0] == 0 ) {// choose first move randomly
       move[0] = 1 + random()% 9;
@@ -257,6 +479,14 @@ void play_games( int num_games, int move[] )
 
     print_board( stdout,board,move[m-1],move[m] );
 
+    for( i = 0; i < 2; i++ ) {
+      if( !is_human[i] ) {
+        times_game_end( &agent_timing[i], usec_left[i] );
+      }
+    }
+    log_game( is_human[0] ? "human" : agent_name[0], is_human[1] ? "human" : agent_name[1],
+              move, move_usec, m, player, game_status );
+
     if( game_status == WIN ) {
       write_agent(  player, "win(triple).\n" );
       write_agent( !player,"loss(triple).\n" );
@@ -278,6 +508,653 @@ void play_games( int num_games, int move[] )
     }
   }
   printf( "\n" );
+
+  for( i = 0; i < 2; i++ ) {
+    if( !is_human[i] ) {
+      times_print( i == 0 ? "agent X" : "agent O", &agent_timing[i] );
+    }
+  }
+}
+
+/*********************************************************//*
+   With -M the server runs many matches at once rather than one.
+   The agents are paired in the order they connect, the first of
+   each pair playing X, and each match plays its own series of
+   games with its own boards and clocks. A single epoll loop waits
+   for every agent at once, with the sockets made non-blocking and
+   the replies collected a line at a time, so a slow agent holds
+   up nobody but its own opponent.
+
+   With -G as well, the server offers each agent to play up to that
+   many of its match's games at the same time over the one
+   connection. After init. it sends multi(G). and an agent that
+   can do this answers multi(K). with K of at most G. From then on
+   every message about a game starts with the game's number, as in
+   3:next_move(5). and the reply 3:7, and the match keeps as many
+   games going as the two agents both agreed to. An agent that
+   answers multi(0). or does not answer in time is played one game
+   at a time without numbers, and so is its opponent.
+*/
+#define MAX_MATCHES   4096
+#define MAX_MULTI       64
+#define CONN_BUF      4096
+#define HELLO_USEC 10000000LL // time an agent has to answer multi(G).
+
+typedef struct match match;
+
+typedef struct {
+  int   fd;                // -1 once closed
+  match *mt;               // the match this agent plays in
+  int   dead;              // TRUE once it has hung up or stopped reading
+  int   multi;             // games it will play at once, 0 for one unnumbered game
+  int   answered;          // TRUE once it has answered multi(G). or run out of time to
+  long long hello_deadline;
+  agent_times times;
+  char  name[GAMELOG_MAX_NAME+1];
+  char  in[CONN_BUF];      // bytes received but not yet used
+  int   in_len;
+  char  out[CONN_BUF];     // bytes the socket would not take yet
+  int   out_len;
+} connection;
+
+typedef struct {
+  match *mt;
+  int id;                  // the game's number in its match, or 0 if none is being played
+  int board[10][10];
+  int move[MAX_MOVE+1];
+  int usec[MAX_MOVE+1];    // time taken over each move
+  int m;
+  int player;              // player to move, or who made the last move
+  long long usec_left[2];
+  int waiting;             // TRUE while waiting for player's move
+  long long asked;         // usec when the move was asked for
+  long long deadline;      // usec when it is too late to reply
+} match_game;
+
+struct match {
+  int id;
+  connection *agent[2];    // X and O
+  match_game games[MAX_MULTI];
+  int multi;               // games played at once, 0 if the messages carry no number
+  int started;             // games started so far
+  int playing;             // games in progress
+  int done;                // TRUE once the match is over
+  int wins[2];             // games won by X and by O
+  int draws;
+};
+
+int epoll_fd;
+connection *connections;
+match *matches;
+int num_matches = 0;       // set with -M
+int max_multi = 0;         // set with -G
+int matches_over = 0;
+int match_games;           // games in each match
+int match_first[2];        // first move given with -m, or 0
+
+/*********************************************************//*
+   Send as much of an agent's output as the socket will take,
+   and ask to be told when it will take the rest
+*/
+void conn_flush( connection *c )
+{
+  struct epoll_event ev;
+  int n;
+
+  while( c->out_len > 0 ) {
+    n = send( c->fd, c->out, c->out_len, MSG_NOSIGNAL );
+    if( n > 0 ) {
+      c->out_len -= n;
+      memmove( c->out, c->out + n, c->out_len );
+    }
+    else if( n < 0 && errno == EINTR ) {
+      continue;
+    }
+    else {
+      if( n < 0 && errno != EAGAIN && errno != EWOULDBLOCK ) {
+        c->dead = TRUE;
+        c->out_len = 0;
+      }
+      break;
+    }
+  }
+  ev.events = c->out_len > 0 ? EPOLLIN | EPOLLOUT : EPOLLIN;
+  ev.data.ptr = c;
+  epoll_ctl( epoll_fd, EPOLL_CTL_MOD, c->fd, &ev );
+}
+
+/*********************************************************//*
+   Write message to an agent, unless it has gone
+*/
+void conn_write( connection *c, char *str )
+{
+  int len = strlen( str );
+  if( c->dead || c->fd < 0 ) {
+    return;
+  }
+  // an agent that lets this much build up is no longer reading
+  if( c->out_len + len > CONN_BUF ) {
+    c->dead = TRUE;
+    return;
+  }
+  memcpy( c->out + c->out_len, str, len );
+  c->out_len += len;
+  conn_flush( c );
+}
+
+/*********************************************************//*
+   Close an agent's connection, at the end of its match
+*/
+void conn_close( connection *c )
+{
+  if( c->fd >= 0 ) {
+    epoll_ctl( epoll_fd, EPOLL_CTL_DEL, c->fd, NULL );
+    close( c->fd );
+    c->fd = -1;
+  }
+}
+
+/*********************************************************//*
+   Take the next complete line the agent has sent, if there is one
+*/
+int conn_line( connection *c, char *line )
+{
+  char *nl = memchr( c->in, '\n', c->in_len );
+  int len;
+
+  if( nl == NULL ) {
+    // a line too long for the buffer is used as it is, and won't parse
+    if( c->in_len < CONN_BUF - 1 ) {
+      return( FALSE );
+    }
+    len = c->in_len;
+  }
+  else {
+    len = nl - c->in + 1;
+  }
+  memcpy( line, c->in, len );
+  line[len] = '\0';
+  c->in_len -= len;
+  memmove( c->in, c->in + len, c->in_len );
+  return( TRUE );
+}
+
+/*********************************************************//*
+   Write message about a game to one of its players, with the
+   game's number in front if the match plays several at once
+*/
+void game_write( match_game *g, int side, char *str )
+{
+  char buf[80];
+  if( g->mt->multi ) {
+    sprintf( buf, "%d:%s", g->id, str );
+    str = buf;
+  }
+  conn_write( g->mt->agent[side], str );
+}
+
+void match_next_game( match *mt, match_game *g );
+
+/*********************************************************//*
+   Tell the players how the game ended, and start another
+*/
+void game_end( match_game *g, int game_status )
+{
+  match *mt = g->mt;
+  int player = g->player;
+  char line[64];
+
+  g->waiting = FALSE;
+  times_game_end( &mt->agent[0]->times, g->usec_left[0] );
+  times_game_end( &mt->agent[1]->times, g->usec_left[1] );
+  log_game( mt->agent[0]->name, mt->agent[1]->name,
+            g->move, g->usec, g->m, player, game_status );
+  if( game_status == WIN || game_status == DRAW ) {
+    sprintf( line, "last_move(%d).\n", g->move[g->m] );
+    game_write( g, !player, line );
+  }
+  printf("match %d game %d  ", mt->id, g->id );
+  if( game_status == WIN ) {
+    game_write( g,  player, "win(triple).\n" );
+    game_write( g, !player,"loss(triple).\n" );
+    printf("Player %c wins (triple)\n", sb[player]);
+    mt->wins[player]++;
+  }
+  else if( game_status == DRAW ) {
+    game_write( g, 0,"draw(full_board).\n" );
+    game_write( g, 1,"draw(full_board).\n" );
+    printf("draw (full_board)\n");
+    mt->draws++;
+  }
+  else {
+    char *cause = game_status == ILLEGAL_MOVE ? "illegal_move" : "timeout";
+    sprintf( line, "loss(%s).\n", cause );
+    game_write( g,  player, line );
+    sprintf( line, "win(%s).\n", cause );
+    game_write( g, !player, line );
+    printf("Player %c wins (%s)\n", sb[!player], cause );
+    mt->wins[!player]++;
+  }
+  fflush( stdout );
+  g->id = 0;
+  mt->playing--;
+  match_next_game( mt, g );
+}
+
+/*********************************************************//*
+   Ask the next player for a move, or end the game if it is over
+*/
+void game_continue( match_game *g, int game_status )
+{
+  char request[64];
+
+  if( g->m >= MAX_MOVE || game_status != STILL_PLAYING ) {
+    game_end( g, game_status );
+    return;
+  }
+  g->m++;
+  g->player = !g->player;
+  if( g->mt->agent[g->player]->dead ) {
+    game_end( g, TIMEOUT );
+    return;
+  }
+  g->usec_left[g->player] += 1000000LL * seconds_per_move;
+  if( send_clock ) {
+    sprintf( request, "clock(%d,%d).\n",
+             ( int )( g->usec_left[g->player]/1000 ), 1000 * seconds_per_move );
+    game_write( g, g->player, request );
+  }
+  move_request( request, g->m, g->move );
+  game_write( g, g->player, request );
+
+  // a reply that comes after the clock has run out would lose anyway
+  g->asked = now_usec();
+  g->deadline = g->asked + ( g->usec_left[g->player] > 0 ? g->usec_left[g->player] : 0 );
+  g->waiting = TRUE;
+}
+
+/*********************************************************//*
+   Stop the clock of the player asked for a move, and charge
+   it the time taken
+*/
+void game_charge( match_game *g )
+{
+  long long think = now_usec() - g->asked;
+  g->waiting = FALSE;
+  g->usec_left[g->player] -= think;
+  g->usec[g->m] = think < 1000000000 ? ( int )think : 1000000000;
+  times_move( &g->mt->agent[g->player]->times, think );
+}
+
+/*********************************************************//*
+   Play the agent's reply to the move request
+*/
+void game_reply( match_game *g, char *line )
+{
+  int game_status;
+  int player = g->player;
+
+  game_charge( g );
+  if( sscanf( line, "%d", &g->move[g->m] ) == 1 ) {
+    game_status = make_move( player,g->m,g->move,g->board );
+  }
+  else {
+    game_status = TIMEOUT;
+  }
+  if(( g->usec_left[player] < 0 )&&( game_status == STILL_PLAYING )) {
+    game_status = TIMEOUT;
+  }
+  game_continue( g, game_status );
+}
+
+/*********************************************************//*
+   Start the next game of a match in place of g, or finish
+   the match once its last game is over
+*/
+void match_next_game( match *mt, match_game *g )
+{
+  if( mt->started >= match_games || mt->agent[0]->dead || mt->agent[1]->dead ) {
+    if( mt->playing > 0 ) {
+      return;   // the rest of its games end first
+    }
+    conn_write( mt->agent[0], "end.\n" );
+    conn_write( mt->agent[1], "end.\n" );
+    conn_close( mt->agent[0] );
+    conn_close( mt->agent[1] );
+    printf("match %d over  X wins %d  O wins %d  draws %d\n",
+           mt->id, mt->wins[0], mt->wins[1], mt->draws );
+    fflush( stdout );
+    mt->done = TRUE;
+    matches_over++;
+    return;
+  }
+  mt->started++;
+  mt->playing++;
+  g->mt = mt;
+  g->id = mt->started;
+  reset_board( g->board );
+  memset( g->usec, 0, sizeof( g->usec ));
+  game_write( g, 0,"start(x).\n" );
+  game_write( g, 1,"start(o).\n" );
+
+  g->usec_left[0] = 1000000LL*(seconds_initially - seconds_per_move);
+  g->usec_left[1] = 1000000LL*(seconds_initially - seconds_per_move);
+
+  if( g->id > 1 || match_first[0] == 0 ) {// choose first move randomly
+    g->move[0] = 1 + random()% 9;
+    g->move[1] = 1 + random()% 9;
+  }
+  else {
+    g->move[0] = match_first[0];
+    g->move[1] = match_first[1];
+  }
+  g->m = 1;
+  g->player = 0;
+  game_continue( g, make_move( g->player,g->m,g->move,g->board ));
+}
+
+/*********************************************************//*
+   Start a match once both its agents are ready, with as many
+   games at once as they will both play
+*/
+void match_start( match *mt )
+{
+  int k;
+
+  if( mt->agent[0] == NULL || mt->agent[1] == NULL || mt->started > 0 || mt->done ) {
+    return;
+  }
+  if( max_multi > 0 ) {
+    if(   !mt->agent[0]->dead && !mt->agent[1]->dead
+       && ( !mt->agent[0]->answered || !mt->agent[1]->answered )) {
+      return;
+    }
+    // if either agent plays one game at a time, so does the match
+    mt->multi = mt->agent[0]->multi < mt->agent[1]->multi
+              ? mt->agent[0]->multi : mt->agent[1]->multi;
+  }
+  // a match with an agent that has gone ends straight away
+  for( k = 0; k < ( mt->multi ? mt->multi : 1 ) && !mt->done; k++ ) {
+    match_next_game( mt, &mt->games[k] );
+  }
+}
+
+/*********************************************************//*
+   Take an agent's answer to multi(G), or NULL if it gave none in
+   time. An agent that answers multi(0). or says nothing, as one
+   written before -G would, plays one game at a time as usual.
+*/
+void conn_hello( connection *c, char *line )
+{
+  int k;
+  c->answered = TRUE;
+  if( line == NULL ) {
+    c->multi = 0;
+  }
+  else if(   sscanf( line, "multi(%d).", &k ) == 1
+          && k >= 0 && k <= max_multi ) {
+    c->multi = k;
+  }
+  else {
+    fprintf( stderr, "match %d: agent did not accept multi(%d).\n", c->mt->id, max_multi );
+    c->dead = TRUE;
+  }
+  match_start( c->mt );
+}
+
+/*********************************************************//*
+   Accept as many waiting agents as there are places for
+*/
+void accept_agents( int server, int *num_connected )
+{
+  struct epoll_event ev;
+  char hello[32];
+  int client;
+
+  while( *num_connected < 2*num_matches ) {
+    client = accept4( server, NULL, NULL, SOCK_NONBLOCK );
+    if( client < 0 ) {
+      if( errno == EINTR ) {
+        continue;
+      }
+      if( errno != EAGAIN && errno != EWOULDBLOCK ) {
+        perror("cannot accept connection ");
+      }
+      return;
+    }
+    set_no_delay( client );
+
+    connection *c = &connections[*num_connected];
+    match *mt = &matches[*num_connected / 2];
+    c->fd = client;
+    c->mt = mt;
+    peer_name( client, c->name );
+    mt->agent[*num_connected % 2] = c;
+    ev.events = EPOLLIN;
+    ev.data.ptr = c;
+    if( epoll_ctl( epoll_fd, EPOLL_CTL_ADD, client, &ev ) < 0 ) {
+      perror("epoll_ctl");
+      exit(1);
+    }
+    conn_write( c, "init.\n" );
+    if( max_multi > 0 ) {
+      sprintf( hello, "multi(%d).\n", max_multi );
+      conn_write( c, hello );
+      c->hello_deadline = now_usec() + HELLO_USEC;
+    }
+    ( *num_connected )++;
+    match_start( mt );
+  }
+}
+
+/*********************************************************//*
+   Find the game a reply is for, and the move in it
+*/
+match_game *find_game( connection *c, char *line, char **reply )
+{
+  match *mt = c->mt;
+  match_game *g = NULL;
+  int k, id, n;
+
+  *reply = line;
+  n = -1;   // only set if the number is followed by a colon
+  if( !mt->multi ) {
+    g = &mt->games[0];
+  }
+  else if( sscanf( line, "%d:%n", &id, &n ) == 1 && n >= 0 ) {
+    for( k = 0; k < mt->multi; k++ ) {
+      if( mt->games[k].id == id ) {
+        g = &mt->games[k];
+      }
+    }
+    *reply = line + n;
+  }
+  // Anything sent when no move was asked for is thrown away.
+  if( g != NULL && ( g->id == 0 || !g->waiting || mt->agent[g->player] != c )) {
+    g = NULL;
+  }
+  return( g );
+}
+
+/*********************************************************//*
+   Read what an agent has sent, and play the moves it was asked for
+*/
+void conn_read( connection *c )
+{
+  match *mt = c->mt;
+  match_game *g;
+  char line[CONN_BUF+1], *reply;
+  int k, n;
+
+  while( c->fd >= 0 ) {
+    n = recv( c->fd, c->in + c->in_len, CONN_BUF - 1 - c->in_len, 0 );
+    if( n < 0 && errno == EINTR ) {
+      continue;
+    }
+    if( n < 0 && ( errno == EAGAIN || errno == EWOULDBLOCK )) {
+      break;
+    }
+    if( n <= 0 ) {
+      // The agent has gone. The moves it owed have run out of time,
+      // and its other games end when it is next asked for a move.
+      c->dead = TRUE;
+      epoll_ctl( epoll_fd, EPOLL_CTL_DEL, c->fd, NULL );
+      if( max_multi > 0 && !c->answered ) {
+        match_start( mt );
+      }
+      for( k = 0; k < MAX_MULTI; k++ ) {
+        g = &mt->games[k];
+        if( g->id != 0 && g->waiting && mt->agent[g->player] == c ) {
+          game_charge( g );
+          game_end( g, TIMEOUT );
+        }
+      }
+      break;
+    }
+    c->in_len += n;
+
+    while( c->fd >= 0 && conn_line( c, line )) {
+      if( max_multi > 0 && !c->answered && !c->dead ) {
+        conn_hello( c, line );
+      }
+      else if(( g = find_game( c, line, &reply )) != NULL ) {
+        game_reply( g, reply );
+      }
+    }
+  }
+}
+
+/*********************************************************//*
+   Run num_matches matches at once, each of num_games games
+*/
+void play_matches( int port, int num_games, int move[] )
+{
+  struct epoll_event ev, events[64];
+  int server, num_connected = 0;
+  int i, k, n, timeout;
+  long long now, wait;
+
+  match_games = num_games;
+  match_first[0] = move[0];
+  match_first[1] = move[1];
+  connections = calloc( 2*num_matches, sizeof( connection ));
+  matches = calloc( num_matches, sizeof( match ));
+  if( connections == NULL || matches == NULL ) {
+    fprintf( stderr, "out of memory\n" );
+    exit(1);
+  }
+  for( i = 0; i < num_matches; i++ ) {
+    matches[i].id = i+1;
+  }
+
+  server = server_listen( port, SOMAXCONN );
+  fcntl( server, F_SETFL, fcntl( server, F_GETFL ) | O_NONBLOCK );
+  epoll_fd = epoll_create1( 0 );
+  if( epoll_fd < 0 ) {
+    perror("epoll_create1");
+    exit(1);
+  }
+  ev.events = EPOLLIN;
+  ev.data.ptr = NULL;   // the server socket
+  epoll_ctl( epoll_fd, EPOLL_CTL_ADD, server, &ev );
+
+  while( matches_over < num_matches ) {
+
+    // wait no longer than the first move or answer that is due
+    wait = -1;
+    now = now_usec();
+    for( i = 0; i < num_matches; i++ ) {
+      for( k = 0; k < MAX_MULTI; k++ ) {
+        match_game *g = &matches[i].games[k];
+        if( g->id != 0 && g->waiting && ( wait < 0 || g->deadline - now < wait )) {
+          wait = g->deadline - now < 0 ? 0 : g->deadline - now;
+        }
+      }
+    }
+    for( i = 0; i < num_connected; i++ ) {
+      connection *c = &connections[i];
+      if(   max_multi > 0 && !c->answered && !c->dead
+         && ( wait < 0 || c->hello_deadline - now < wait )) {
+        wait = c->hello_deadline - now < 0 ? 0 : c->hello_deadline - now;
+      }
+    }
+    // epoll_wait counts in msec, so round up rather than wake too soon
+    timeout = wait < 0 ? -1 : ( int )(( wait + 999 ) / 1000 );
+
+    n = epoll_wait( epoll_fd, events, 64, timeout );
+    if( n < 0 && errno != EINTR ) {
+      perror("epoll_wait");
+      exit(1);
+    }
+    for( i = 0; i < n; i++ ) {
+      connection *c = events[i].data.ptr;
+      if( c == NULL ) {
+        accept_agents( server, &num_connected );
+        if( num_connected == 2*num_matches && server >= 0 ) {
+          epoll_ctl( epoll_fd, EPOLL_CTL_DEL, server, NULL );
+          close( server );
+          server = -1;
+        }
+        continue;
+      }
+      if( c->fd < 0 ) {
+        continue;   // closed by an earlier event
+      }
+      if( events[i].events & EPOLLOUT ) {
+        conn_flush( c );
+      }
+      if( events[i].events & ( EPOLLIN | EPOLLHUP | EPOLLERR )) {
+        conn_read( c );
+      }
+    }
+
+    now = now_usec();
+    for( i = 0; i < num_connected; i++ ) {
+      connection *c = &connections[i];
+      if( max_multi > 0 && !c->answered && !c->dead && now >= c->hello_deadline ) {
+        conn_hello( c, NULL );
+      }
+    }
+    for( i = 0; i < num_matches; i++ ) {
+      for( k = 0; k < MAX_MULTI; k++ ) {
+        match_game *g = &matches[i].games[k];
+        if( g->id != 0 && g->waiting && now >= g->deadline ) {
+          game_charge( g );
+          game_end( g, TIMEOUT );
+        }
+      }
+    }
+  }
+
+  int wins[2] = {0,0}, draws = 0;
+  for( i = 0; i < num_matches; i++ ) {
+    wins[0] += matches[i].wins[0];
+    wins[1] += matches[i].wins[1];
+    draws += matches[i].draws;
+  }
+  printf("\n%d matches  X wins %d  O wins %d  draws %d\n",
+         num_matches, wins[0], wins[1], draws );
+
+  // each agent's think times, and all the agents' together
+  agent_times all;
+  char name[32];
+  memset( &all, 0, sizeof( all ));
+  for( i = 0; i < 2*num_matches; i++ ) {
+    sprintf( name, "match %d %c", i/2 + 1, sb[i % 2] );
+    times_print( name, &connections[i].times );
+    times_add( &all, &connections[i].times );
+    free( connections[i].times.think );
+  }
+  if( num_matches > 1 ) {
+    times_print( "all agents", &all );
+  }
+  free( all.think );
+  if( server >= 0 ) {
+    close( server );
+  }
+  close( epoll_fd );
+  free( connections );
+  free( matches );
 }
 
 /*********************************************************//*
@@ -309,6 +1186,10 @@ void usage( char argv0[] )
   // number of seconds allocated initially, and per move
   printf("       [-t initial permove]\n");
   printf("       [-n num_games]\n");   // number of games
+  printf("       [-c]\n");             // send the time left with each move request
+  printf("       [-M matches]\n");    // matches to run at once, one pair of agents each
+  printf("       [-G games]\n");      // games of each match an agent may play at once
+  printf("       [-l game_log]\n");   // add each game to a log
   exit(1);
 }
 
@@ -368,6 +1249,40 @@ int main(int argc, char *argv[])
       num_games = atoi(argv[i+1]);
       i += 2;
     }
+    else if( strcmp( argv[i], "-l" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      game_log = gamelog_append( argv[i+1] );
+      if( game_log == NULL ) {
+        exit(1);
+      }
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-c" ) == 0 ) {
+      send_clock = TRUE;
+      i++;
+    }
+    else if( strcmp( argv[i], "-G" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      max_multi = atoi(argv[i+1]);
+      if( max_multi < 1 || max_multi > MAX_MULTI ) {
+        usage( argv[0] );
+      }
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-M" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      num_matches = atoi(argv[i+1]);
+      if( num_matches < 1 || num_matches > MAX_MATCHES ) {
+        usage( argv[0] );
+      }
+      i += 2;
+    }
     else {
       usage( argv[0] );
     }
@@ -377,12 +1292,25 @@ int main(int argc, char *argv[])
   gettimeofday( &tp, NULL );
   srandom(( unsigned int )( tp.tv_usec ));
 
+  if( max_multi > 0 && num_matches == 0 ) {
+    num_matches = 1;
+  }
+  if( num_matches > 0 ) {
+    if( is_human[0] || is_human[1] ) {
+      usage( argv[0] );
+    }
+    play_matches( port, num_games, move );
+    gamelog_close( game_log );
+    return 0;
+  }
+
   if( !is_human[0] || !is_human[1] ) {
     server_init( port );
   }
   play_games( num_games,move );
 
   cleanup();
+  gamelog_close( game_log );
 
   return 0;
 }
@@ -0,0 +1,234 @@
+/*********************************************************
+ *  solver.c
+ *  Nine-Board Tic-Tac-Toe Endgame Solver
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Once few enough cells are left empty, the whole remaining tree
+ *  can be searched to the end of the game, so there is no need for
+ *  the heuristic at all. Every position is then simply a win, loss
+ *  or draw, and wins are scored by how soon they happen.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "bitboard.h"
+#include "tables.h"
+#include "engine.h"
+#include "search.h"
+#include "solver.h"
+
+// how a stored score relates to the true value, as in ttable.h
+#define SOLVE_UPPER  1
+#define SOLVE_LOWER  2
+#define SOLVE_EXACT  3
+
+typedef struct solve_entry {
+  uint64_t key;
+  int16_t score;   // distance to the end counted from this position, not the root
+  uint8_t bound;
+  uint8_t move;
+} solve_entry;
+
+static int solve(engine *e, int current_board, int current_player, int alpha, int beta, int ply);
+
+/*********************************************************//*
+   Allocate the solver's own hash table, using at most the given number of megabytes
+*/
+void solver_init( solver_state *s, int megabytes )
+{
+  uint64_t entries = 1;
+  while (entries * 2 * sizeof(solve_entry) <= (uint64_t)megabytes << 20) {
+    entries *= 2;
+  }
+
+  solver_free(s);
+  s->table = calloc(entries, sizeof(solve_entry));
+  if (s->table == NULL) {
+    perror("cannot allocate solver table ");
+    exit(1);
+  }
+  s->mask = entries - 1;
+}
+
+/*********************************************************//*
+   Release the solver's hash table
+*/
+void solver_free( solver_state *s )
+{
+  free(s->table);
+  s->table = NULL;
+}
+
+/*********************************************************//*
+   Solves the engine's position exactly, returning the best move, or -1 if it could not be
+   proven in time
+*/
+int solve_root( engine *e, int current_board, int current_player, int msec_limit, int *score )
+{
+
+  // The root is searched here, rather than in solve, so that we know which move gave the best
+  // score. Since every score is exact there is no window to guess, and we only need to search
+  // with the full range of scores.
+  int alpha = -SOLVE_WIN - 1;
+  int beta = SOLVE_WIN + 1;
+  solver_state *s = &e->solver;
+  int this_move = -1;
+  int i;
+
+  if (s->table == NULL) {
+    return -1;
+  }
+  s->pos = e->pos;
+  s->limit = msec_limit;
+  s->aborted = FALSE;
+  s->nodes = 0;
+
+  int empty = pos_empty(&s->pos, current_board);
+  for (i = 1; i <= 9; ++i) {
+    if (!(empty & CELL_BIT(i))) {
+      continue;
+    }
+    int value;
+    int status = pos_make(&s->pos, current_player, current_board, i);
+    if (status == WIN) {
+      value = SOLVE_WIN - 1;
+    } else if (status == DRAW) {
+      value = 0;
+    } else {
+      value = -solve(e, i, !current_player, -beta, -alpha, 1);
+    }
+    pos_unmake(&s->pos, current_player, current_board, i);
+
+    if (s->aborted) {
+      return -1;
+    }
+    if (value > alpha) {
+      alpha = value;
+      this_move = i;
+    }
+  }
+  *score = alpha;
+  return this_move;
+}
+
+/*********************************************************//*
+   Exact negamax alpha-beta search to the end of the game
+*/
+static int solve( engine *e, int current_board, int current_player, int alpha, int beta, int ply )
+{
+  solver_state *s = &e->solver;
+  int empty = pos_empty(&s->pos, current_board);
+  int i;
+
+  // The solve is abandoned if it runs out of time, or if a search on the opponent's time is
+  // told to stop, and whatever it was doing is thrown away.
+  if ((++s->nodes & 1023) == 0 && elapsed_msec(e) >= s->limit) {
+    s->aborted = TRUE;
+  }
+  if (s->aborted || search_stopped(e)) {
+    s->aborted = TRUE;
+    return 0;
+  }
+
+  // If we can complete a line on this board there is nothing to search, as no win can come
+  // sooner than that.
+  if (s->pos.threat[current_player][current_board]) {
+    return SOLVE_WIN - ply - 1;
+  }
+
+  // Otherwise the best we can hope for is to win with our second move from here, and the worst
+  // is to lose to the opponent's next move. Narrowing the window to that range prunes lines
+  // that could not beat a quicker win or a slower loss already found.
+  if (alpha < -(SOLVE_WIN - ply - 2)) {
+    alpha = -(SOLVE_WIN - ply - 2);
+  }
+  if (beta > SOLVE_WIN - ply - 3) {
+    beta = SOLVE_WIN - ply - 3;
+  }
+  if (alpha >= beta) {
+    return alpha;
+  }
+
+  // Stored scores count the distance to the end from the position they belong to, since the
+  // same position can be reached at different plies, and are converted back here.
+  uint64_t key = s->pos.hash ^ zobrist_board[current_board];
+  solve_entry *entry = &s->table[key & s->mask];
+  int hash_move = 0;
+  if (entry->key == key) {
+    int stored = entry->score > 0 ? entry->score - ply : entry->score < 0 ? entry->score + ply : 0;
+    if (entry->bound == SOLVE_EXACT
+        || (entry->bound == SOLVE_LOWER && stored >= beta)
+        || (entry->bound == SOLVE_UPPER && stored <= alpha)) {
+      return stored;
+    }
+    hash_move = entry->move;
+  }
+
+  // The move from the table is tried first, then the others in order of the heuristic value
+  // they leave us with, which is a good enough guess at which ones will win.
+  int moves[9];
+  int order[9];
+  int num_moves = 0;
+  for (i = 1; i <= 9; ++i) {
+    if (!(empty & CELL_BIT(i))) {
+      continue;
+    }
+    pos_make(&s->pos, current_player, current_board, i);
+    int score = current_player == 0 ? s->pos.total : -s->pos.total;
+    pos_unmake(&s->pos, current_player, current_board, i);
+    if (i == hash_move) {
+      score = 1 << 30;
+    }
+    int k = num_moves++;
+    while (k > 0 && order[k - 1] < score) {
+      moves[k] = moves[k - 1];
+      order[k] = order[k - 1];
+      --k;
+    }
+    moves[k] = i;
+    order[k] = score;
+  }
+
+  int original_alpha = alpha;
+  int best_move = 0;
+  int n;
+  for (n = 0; n < num_moves; ++n) {
+    i = moves[n];
+    int value;
+    int status = pos_make(&s->pos, current_player, current_board, i);
+
+    // We cannot have won with this move, or it would have been found above. If it sends the
+    // opponent to a board where they can complete a line, it loses straight away and there
+    // is no need to search any further.
+    if (status == DRAW) {
+      value = 0;
+    } else if (s->pos.threat[!current_player][i]) {
+      value = -(SOLVE_WIN - ply - 2);
+    } else {
+      value = -solve(e, i, !current_player, -beta, -alpha, ply + 1);
+    }
+    pos_unmake(&s->pos, current_player, current_board, i);
+
+    if (s->aborted) {
+      return 0;
+    }
+    if (value > alpha) {
+      alpha = value;
+      best_move = i;
+      if (alpha >= beta) {
+        break;
+      }
+    }
+  }
+
+  // Every entry is replaced, since the solver's positions are all close to the end of the game
+  // and none of them is much more expensive to find again than another.
+  entry->key = key;
+  entry->score = alpha > 0 ? alpha + ply : alpha < 0 ? alpha - ply : 0;
+  entry->bound = alpha >= beta ? SOLVE_LOWER : alpha > original_alpha ? SOLVE_EXACT : SOLVE_UPPER;
+  entry->move = best_move;
+  return alpha;
+}
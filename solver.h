@@ -0,0 +1,39 @@
+/*********************************************************
+ *  solver.h
+ *  Nine-Board Tic-Tac-Toe Endgame Solver
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#ifndef SOLVER_H
+#define SOLVER_H
+
+#include "bitboard.h"
+
+// A win for the side to move at ply n of the solve scores SOLVE_WIN - n, so
+// the sooner the win the higher the score, and a loss scores the negative.
+#define SOLVE_WIN 1000
+
+// The solver's own table and copy of the position, one for each engine
+typedef struct {
+  struct solve_entry *table;
+  uint64_t mask;     // number of entries - 1
+  position pos;      // the position being solved
+  int limit;         // msec the solve may run for
+  int aborted;       // TRUE once it has run out of time or been told to stop
+  long nodes;        // nodes visited by the last call to solve_root
+} solver_state;
+
+struct engine;
+
+// Allocate the solver's own hash table, using at most the given number of megabytes
+void solver_init(solver_state *s, int megabytes);
+
+// Release the solver's hash table
+void solver_free(solver_state *s);
+
+// Solves the engine's position exactly, with current_player to move in current_board, giving
+// up once the search has run for msec_limit. Returns the best move and sets *score, or returns
+// -1 if the result could not be proven in time.
+int solve_root(struct engine *e, int current_board, int current_player, int msec_limit, int *score);
+
+#endif
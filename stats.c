@@ -0,0 +1,88 @@
+/*********************************************************
+ *  stats.c
+ *  Nine-Board Tic-Tac-Toe Search Statistics
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#include <stdio.h>
+
+#include "common.h"
+#include "engine.h"
+#include "search.h"
+#include "stats.h"
+
+#ifdef SEARCH_STATS
+/*********************************************************//*
+   Nodes searched by the main thread's iteration at depth d
+*/
+static long iteration_nodes( search_stats *s, int d )
+{
+  return s->depth_nodes[d] - ( d > 1 ? s->depth_nodes[d-1] : 0 );
+}
+#endif
+
+/*********************************************************//*
+   Write the statistics of the last search for a move
+*/
+void print_stats( engine *e, FILE *fp, int json, int move_number )
+{
+  int msec = elapsed_msec( e );
+  long nodes = e->nodes;
+  long nps = msec > 0 ? nodes * 1000 / msec : nodes * 1000;
+#ifdef SEARCH_STATS
+  search_stats *s = &e->last_stats;
+  int depths = s->depths;
+  int d, k;
+
+  // The effective branching factor is how many times more nodes the last iteration took than
+  // the one before it, which is what each extra ply of depth costs.
+  double ebf = 0.0;
+  if( depths > 1 && iteration_nodes( s, depths-1 ) > 0 ) {
+    ebf = ( double )iteration_nodes( s, depths ) / iteration_nodes( s, depths-1 );
+  }
+#endif
+
+  if( json ) {
+    fprintf( fp, "{\"move\":%d,\"depth\":%d,\"score\":%d,\"msec\":%d,\"nodes\":%ld,\"nps\":%ld",
+             move_number, e->search_depth, e->search_score, msec, nodes, nps );
+#ifdef SEARCH_STATS
+    fprintf( fp, ",\"leaf_evals\":%ld,\"terminal_hits\":%ld,\"quiesce_nodes\":%ld"
+                 ",\"gift_prunes\":%ld,\"hash_probes\":%ld,\"hash_hits\":%ld"
+                 ",\"hash_cutoffs\":%ld,\"ebf\":%.2f,\"cutoffs_at\":[",
+             s->leaf_evals, s->terminal_hits, s->quiesce_nodes,
+             s->gift_prunes, s->hash_probes, s->hash_hits,
+             s->hash_cutoffs, ebf );
+    for( k = 0; k < 9; k++ ) {
+      fprintf( fp, "%s%ld", k ? "," : "", s->cutoffs_at[k] );
+    }
+    fprintf( fp, "],\"iterations\":[" );
+    for( d = 1; d <= depths; d++ ) {
+      fprintf( fp, "%s{\"depth\":%d,\"msec\":%d,\"nodes\":%ld}", d > 1 ? "," : "",
+               d, s->depth_msec[d], iteration_nodes( s, d ));
+    }
+    fprintf( fp, "]" );
+#endif
+    fprintf( fp, "}\n" );
+  }
+  else {
+    fprintf( fp, "move %d  depth %d  score %d  msec %d  nodes %ld  nps %ld\n",
+             move_number, e->search_depth, e->search_score, msec, nodes, nps );
+#ifdef SEARCH_STATS
+    fprintf( fp, "  leaf evals %ld  terminal hits %ld  quiesce nodes %ld  gift prunes %ld\n",
+             s->leaf_evals, s->terminal_hits, s->quiesce_nodes,
+             s->gift_prunes );
+    fprintf( fp, "  hash probes %ld  hits %ld  cutoffs %ld  ebf %.2f\n",
+             s->hash_probes, s->hash_hits, s->hash_cutoffs, ebf );
+    fprintf( fp, "  cutoffs by move" );
+    for( k = 0; k < 9; k++ ) {
+      fprintf( fp, " %ld", s->cutoffs_at[k] );
+    }
+    fprintf( fp, "\n" );
+    for( d = 1; d <= depths; d++ ) {
+      fprintf( fp, "  depth %2d  msec %6d  nodes %10ld\n",
+               d, s->depth_msec[d], iteration_nodes( s, d ));
+    }
+#endif
+  }
+  fflush( fp );
+}
@@ -0,0 +1,51 @@
+/*********************************************************
+ *  stats.h
+ *  Nine-Board Tic-Tac-Toe Search Statistics
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  The detailed counters are only kept when the engine is built
+ *  with SEARCH_STATS defined, which the Makefile does unless it is
+ *  run as "make STATS=". Otherwise the STAT macros expand to
+ *  nothing and the counters cost nothing at all.
+ */
+#ifndef STATS_H
+#define STATS_H
+
+#include <stdio.h>
+
+#define STATS_DEPTHS 82   // same as MAX_PLY
+
+typedef struct {
+  long leaf_evals;              // positions given a heuristic value
+  long terminal_hits;           // positions found won, lost or drawn without a search
+  long hash_probes;
+  long hash_hits;               // probes that found the position
+  long hash_cutoffs;            // ... and answered it without a search
+  long quiesce_nodes;           // forced moves followed past the depth of the search
+  long gift_prunes;             // moves scored as losses without a search
+  long cutoffs_at[9];           // cutoffs caused by the first, second, ... move tried
+  int  depths;                  // iterations the main thread completed
+  int  depth_msec[STATS_DEPTHS];  // when each iteration of the main thread finished
+  long depth_nodes[STATS_DEPTHS]; // ... and its nodes so far
+} search_stats;
+
+#ifdef SEARCH_STATS
+#define STAT_INC(t, field)       ((t)->stats.field++)
+#define STAT_CUTOFF(t, n)        ((t)->stats.cutoffs_at[n]++)
+#define STAT_DEPTH(t, d, msec)   ((t)->stats.depths = (d), \
+                                  (t)->stats.depth_msec[d] = (msec), \
+                                  (t)->stats.depth_nodes[d] = (t)->nodes)
+#else
+#define STAT_INC(t, field)       ((void)0)
+#define STAT_CUTOFF(t, n)        ((void)0)
+#define STAT_DEPTH(t, d, msec)   ((void)0)
+#endif
+
+struct engine;
+
+// Writes the statistics of the engine's last search for a move, as one line of JSON if json
+// is TRUE, or else as text
+void print_stats(struct engine *e, FILE *fp, int json, int move_number);
+
+#endif
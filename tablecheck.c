@@ -0,0 +1,90 @@
+/*********************************************************
+ *  tablecheck.c
+ *  Nine-Board Tic-Tac-Toe Sub-Board Pattern Table Check
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Runs through every sub-board state and compares the generated
+ *  tables with the agent's mask-based evaluation rules, which are
+ *  an independent implementation of the ones mktables uses.
+ */
+#include <stdio.h>
+
+#include "bitboard.h"
+#include "tables.h"
+
+/*********************************************************
+   Heuristic of a sub-board from X's view, counting the pieces
+   of each line with masks
+*/
+int mask_heuristic( int mine, int theirs )
+{
+  int x2=0,x1=0,o2=0,o1=0;
+  int l,x,o;
+  for( l = 0; l < 8; l++ ) {
+    x = pop_count[mine   & win_lines[l]];
+    o = pop_count[theirs & win_lines[l]];
+    if( o == 0 ) {
+      if( x == 2 ) x2++;
+      if( x == 1 ) x1++;
+    }
+    else if( x == 0 ) {
+      if( o == 2 ) o2++;
+      if( o == 1 ) o1++;
+    }
+  }
+  return( 3*x2 + x1 - ( 3*o2 + o1 ));
+}
+
+/*********************************************************
+   Empty cells where the mask would complete a line
+*/
+int mask_threats( int mine, int empty )
+{
+  int mask=0;
+  int c;
+  for( c = 1; c <= 9; c++ ) {
+    if(( empty & CELL_BIT(c)) && mask_won( mine | CELL_BIT(c) )) {
+      mask |= CELL_BIT(c);
+    }
+  }
+  return( mask );
+}
+
+/*********************************************************/
+int main( void )
+{
+  int errors=0;
+  int x,o;
+
+  for( x = 0; x < 512; x++ ) {
+    for( o = 0; o < 512; o++ ) {
+      int i, flags, empty;
+      if( x & o ) {
+        continue; // not a sub-board state
+      }
+      i = pattern_index( x,o );
+      empty = ~( x | o ) & FULL_MASK;
+      flags = ( mask_won( x ) ? PATTERN_WON(0) : 0 )
+            | ( mask_won( o ) ? PATTERN_WON(1) : 0 )
+            | ( empty == 0 ? PATTERN_FULL : 0 );
+      if(   i < 0 || i >= NUM_PATTERNS
+         || pattern_score[i] != mask_heuristic( x,o )
+         || pattern_flags[i] != flags
+         || pattern_threat[0][i] != mask_threats( x,empty )
+         || pattern_threat[1][i] != mask_threats( o,empty )) {
+        if( errors < 10 ) {
+          printf("mismatch at x=%03x o=%03x (state %d)\n",x,o,i);
+        }
+        errors++;
+      }
+    }
+  }
+
+  if( errors > 0 ) {
+    printf("%d of %d states do not match\n",errors,NUM_PATTERNS);
+    return 1;
+  }
+  printf("all %d states match\n",NUM_PATTERNS);
+  return 0;
+}
@@ -0,0 +1,47 @@
+/*********************************************************
+ *  tables.h
+ *  Nine-Board Tic-Tac-Toe Sub-Board Pattern Tables
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  The tables themselves are generated into tables.c by mktables.
+ */
+#ifndef TABLES_H
+#define TABLES_H
+
+#include <stdint.h>
+
+// Number of distinct sub-board states, 3^9
+#define NUM_PATTERNS   19683
+
+// Bits of pattern_flags
+#define PATTERN_WON(p) ( 1 << (p) )  // player p has three in a row
+#define PATTERN_FULL   4             // no empty cells left
+
+// Base-3 weight of each 9-bit mask, so that a sub-board holding
+// X pieces x and O pieces o is state ternary[x] + 2*ternary[o]
+extern const uint16_t ternary[512];
+
+// Heuristic 3*X2 + X1 - (3*O2 + O1) of each state, from X's view
+extern const int8_t   pattern_score[NUM_PATTERNS];
+
+// Won and full flags of each state
+extern const uint8_t  pattern_flags[NUM_PATTERNS];
+
+// Empty cells where each player would complete a line
+extern const uint16_t pattern_threat[2][NUM_PATTERNS];
+
+// Random keys for Zobrist hashing, one for each player, sub-board and
+// cell, and one for each sub-board the next move must be played in
+extern const uint64_t zobrist[2][10][10];
+extern const uint64_t zobrist_board[10];
+
+/*********************************************************
+   State index of a sub-board from its two player masks
+*/
+static inline int pattern_index( int x, int o )
+{
+  return ternary[x] + 2*ternary[o];
+}
+
+#endif
@@ -0,0 +1,498 @@
+/*********************************************************
+ *  tourney.c
+ *  Nine-Board Tic-Tac-Toe Tournament
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  Plays two configurations of the search against each other on
+ *  as many worker processes as there are cores. Every opening is
+ *  played twice, once with each configuration as X, so neither
+ *  gains from the openings it happened to be given. After each
+ *  game the Elo difference of A over B is estimated with its 95%
+ *  error, and if a sequential probability ratio test is asked for
+ *  the tournament stops as soon as it shows whether A is better
+ *  by elo1 or by no more than elo0.
+ *
+ *  Each game is written to the results file as it finishes, and
+ *  if the tournament is run again with the same file and the same
+ *  settings it carries on from where it stopped.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <unistd.h>
+#include <signal.h>
+#include <sys/select.h>
+#include <sys/wait.h>
+
+#include "common.h"
+#include "bitboard.h"
+#include "engine.h"
+#include "match.h"
+
+#define MAX_WORKERS  256
+#define MAX_GAMES    100000
+
+typedef struct {
+  pid_t pid;
+  FILE *in;     // tasks to the worker
+  FILE *out;    // results from the worker
+  int   busy;   // TRUE while it is playing a game
+} worker;
+
+engine_config config[2];   // A and B
+engine *players[2];        // their engines, in a worker
+char *openings_file = NULL;
+game_record *openings = NULL;
+int num_openings = 0;
+int plies = 4;
+int seed = 1;
+int megabytes = 2;
+
+worker workers[MAX_WORKERS];
+int num_workers;
+char played[MAX_GAMES];    // TRUE once game k is in the results file
+int wins, draws, losses;   // from A's point of view
+
+/*********************************************************//*
+   Print usage information and exit
+*/
+void usage( char argv0[] )
+{
+  printf("Usage: %s\n",argv0);
+  printf("       [-a config]\n");       // settings for A, such as depth=8
+  printf("       [-b config]\n");       // settings for B
+  printf("       [-n num_games]\n");    // most games to play
+  printf("       [-j workers]\n");      // worker processes, one per core by default
+  printf("       [-r plies]\n");        // random moves after the first in each opening
+  printf("       [-f openings]\n");     // file of openings instead
+  printf("       [-S seed]\n");         // seed the random openings are chosen from
+  printf("       [-s elo0 elo1]\n");    // stop early by SPRT
+  printf("       [-H megabytes]\n");    // memory for the search tables of each side in each worker
+  printf("       [results]\n");         // file the games are written to
+  exit(1);
+}
+
+/*********************************************************//*
+   The opening of pair k, which is the same whenever it is asked for
+*/
+void get_opening( int k, game_record *g )
+{
+  if( num_openings > 0 ) {
+    *g = openings[k % num_openings];
+  }
+  else {
+    srandom(( unsigned int )( seed * 1000003 + k ));
+    opening_random( g, 0, 0, plies );
+  }
+}
+
+/*********************************************************//*
+   Play game k, with A as X in the first game of each pair and as
+   O in the second, and write a line of the results file for it
+*/
+void play_task( int k, FILE *fp )
+{
+  engine_config sides[2];
+  engine *engines[2];
+  game_record opening, game;
+  int cause, result;
+  int a = k % 2;   // the side A plays
+
+  get_opening( k / 2, &opening );
+  sides[a] = config[0];
+  sides[!a] = config[1];
+  engines[a] = players[0];
+  engines[!a] = players[1];
+  result = play_game( engines, sides, &opening, &game, &cause );
+  if( a == 1 && result != DRAW ) {
+    result = ( result == WIN ? LOSS : WIN );
+  }
+  fprintf( fp, "%d %c %c ", k, sb[a], result == WIN ? 'W' : result == LOSS ? 'L' : 'D' );
+  record_print( fp, &game );
+  fprintf( fp, "\n" );
+  fflush( fp );
+}
+
+/*********************************************************//*
+   Body of a worker process, which plays the games it is sent
+   until its input is closed
+*/
+void worker_main( FILE *in, FILE *out )
+{
+  int k;
+  players[0] = engine_new( megabytes );
+  players[1] = engine_new( megabytes );
+  if( players[0] == NULL || players[1] == NULL ) {
+    fprintf( stderr, "out of memory\n" );
+    exit(1);
+  }
+  while( fscanf( in, "%d", &k ) == 1 ) {
+    play_task( k, out );
+  }
+  engine_free( players[0] );
+  engine_free( players[1] );
+  exit(0);
+}
+
+/*********************************************************//*
+   Start a worker process connected by a pair of pipes
+*/
+int start_worker( worker *w )
+{
+  int to_worker[2], from_worker[2];
+  int k;
+
+  if( pipe( to_worker ) < 0 || pipe( from_worker ) < 0 ) {
+    return( FALSE );
+  }
+  fflush( stdout );
+  w->pid = fork();
+  if( w->pid < 0 ) {
+    return( FALSE );
+  }
+  if( w->pid == 0 ) {
+    for( k = 0; &workers[k] < w; k++ ) {
+      fclose( workers[k].in );
+      fclose( workers[k].out );
+    }
+    close( to_worker[1] );
+    close( from_worker[0] );
+    worker_main( fdopen( to_worker[0], "r" ), fdopen( from_worker[1], "w" ));
+  }
+  close( to_worker[0] );
+  close( from_worker[1] );
+  w->in = fdopen( to_worker[1], "w" );
+  w->out = fdopen( from_worker[0], "r" );
+  w->busy = FALSE;
+  return( TRUE );
+}
+
+/*********************************************************//*
+   Score of A, with its variance per game
+*/
+void get_score( double *score, double *variance )
+{
+  int n = wins + draws + losses;
+  double s = ( wins + 0.5 * draws ) / n;
+  *score = s;
+  *variance = (  wins   * ( 1.0 - s ) * ( 1.0 - s )
+               + draws  * ( 0.5 - s ) * ( 0.5 - s )
+               + losses * s * s ) / n;
+}
+
+/*********************************************************//*
+   Elo difference that gives an expected score of s
+*/
+double elo( double s )
+{
+  if( s <= 0.0 ) return( -INFINITY );
+  if( s >= 1.0 ) return(  INFINITY );
+  return( -400.0 * log10( 1.0 / s - 1.0 ));
+}
+
+/*********************************************************//*
+   Log-likelihood ratio of A being elo1 better rather than elo0,
+   using the normal approximation to the game scores
+*/
+double llr( double elo0, double elo1 )
+{
+  int n = wins + draws + losses;
+  double s, variance;
+  double s0 = 1.0 / ( 1.0 + pow( 10.0, -elo0 / 400.0 ));
+  double s1 = 1.0 / ( 1.0 + pow( 10.0, -elo1 / 400.0 ));
+
+  get_score( &s, &variance );
+  if( variance <= 0.0 ) {
+    return( 0.0 );
+  }
+  return( n * ( s1 - s0 ) * ( 2.0 * s - s0 - s1 ) / ( 2.0 * variance ));
+}
+
+/*********************************************************//*
+   Print the standings so far
+*/
+void print_standings( FILE *fp, int sprt, double elo0, double elo1 )
+{
+  int n = wins + draws + losses;
+  double s, variance, margin;
+
+  if( n == 0 ) {
+    return;
+  }
+  get_score( &s, &variance );
+  margin = 1.96 * sqrt( variance / n );
+  fprintf( fp, "games %d  A wins %d  draws %d  losses %d  score %.1f%%  elo %.1f +/- %.1f",
+           n, wins, draws, losses, 100.0 * s, elo( s ),
+           ( elo( s + margin ) - elo( s - margin )) / 2.0 );
+  if( sprt ) {
+    fprintf( fp, "  llr %.2f", llr( elo0, elo1 ));
+  }
+  fprintf( fp, "\n" );
+  fflush( fp );
+}
+
+/*********************************************************//*
+   Count a line of the results file, returning FALSE if it is not one
+*/
+int count_result( char *line, int num_games )
+{
+  int k;
+  char side, result;
+
+  if( sscanf( line, "%d %c %c", &k, &side, &result ) != 3 || k < 0 || k >= num_games ) {
+    return( FALSE );
+  }
+  if( !played[k] ) {
+    played[k] = TRUE;
+    wins   += ( result == 'W' );
+    draws  += ( result == 'D' );
+    losses += ( result == 'L' );
+  }
+  return( TRUE );
+}
+
+/*********************************************************/
+int main( int argc, char *argv[] )
+{
+  char *results_file = "tourney.txt";
+  char header[600], line[600];
+  int num_games = 1000;
+  int sprt = FALSE;
+  double elo0 = 0.0, elo1 = 5.0;
+  double lower, upper;
+  int next_game = 0, running = 0;
+  int i=1, k;
+  FILE *fp;
+
+  config_default( &config[0] );
+  config_default( &config[1] );
+  num_workers = sysconf( _SC_NPROCESSORS_ONLN );
+
+  while( i < argc ) {
+    if( strcmp( argv[i], "-a" ) == 0 || strcmp( argv[i], "-b" ) == 0 ) {
+      if( i+1 >= argc || !config_parse( argv[i+1], &config[argv[i][1] == 'b'] )) {
+        usage( argv[0] );
+      }
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-n" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      num_games = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-j" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      num_workers = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-r" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      plies = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-f" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      openings_file = argv[i+1];
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-S" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      seed = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( strcmp( argv[i], "-s" ) == 0 ) {
+      if( i+2 >= argc ) {
+        usage( argv[0] );
+      }
+      elo0 = atof(argv[i+1]);
+      elo1 = atof(argv[i+2]);
+      sprt = TRUE;
+      i += 3;
+    }
+    else if( strcmp( argv[i], "-H" ) == 0 ) {
+      if( i+1 >= argc ) {
+        usage( argv[0] );
+      }
+      megabytes = atoi(argv[i+1]);
+      i += 2;
+    }
+    else if( argv[i][0] != '-' ) {
+      results_file = argv[i];
+      i++;
+    }
+    else {
+      usage( argv[0] );
+    }
+  }
+  num_games += num_games % 2;   // whole pairs only
+  if(   num_games < 2 || num_games > MAX_GAMES || num_workers < 1
+     || num_workers > MAX_WORKERS || plies < 0 || plies > 40
+     || megabytes < 1 || elo1 <= elo0 ) {
+    usage( argv[0] );
+  }
+
+  if( openings_file != NULL ) {
+    fp = fopen( openings_file, "r" );
+    if( fp == NULL ) {
+      perror( openings_file );
+      exit(1);
+    }
+    openings = malloc( num_games / 2 * sizeof( game_record ));
+    while( num_openings < num_games / 2 && fgets( line, sizeof( line ), fp ) != NULL ) {
+      if( opening_read( line, &openings[num_openings] )) {
+        num_openings++;
+      }
+    }
+    fclose( fp );
+    if( num_openings == 0 ) {
+      fprintf( stderr, "%s: no openings\n", openings_file );
+      exit(1);
+    }
+  }
+
+  // The first line of the results file gives the settings, and the games
+  // already in it are only carried on from if they were played the same way.
+  fp = fmemopen( header, sizeof( header ), "w" );
+  fprintf( fp, "# A " );
+  config_print( fp, &config[0] );
+  fprintf( fp, "  B " );
+  config_print( fp, &config[1] );
+  if( openings_file != NULL ) {
+    fprintf( fp, "  openings %s\n", openings_file );
+  }
+  else {
+    fprintf( fp, "  plies %d  seed %d\n", plies, seed );
+  }
+  fclose( fp );
+
+  // A file that is missing or empty is started afresh, and the header is
+  // written to it below.
+  fp = fopen( results_file, "r" );
+  if( fp != NULL && fgets( line, sizeof( line ), fp ) != NULL ) {
+    if( strcmp( line, header ) != 0 ) {
+      fprintf( stderr, "%s was played with other settings:\n%s", results_file, line );
+      exit(1);
+    }
+    while( fgets( line, sizeof( line ), fp ) != NULL ) {
+      count_result( line, num_games );
+    }
+    fclose( fp );
+    if( wins + draws + losses > 0 ) {
+      printf("resuming after %d games\n", wins + draws + losses );
+    }
+  }
+  else if( fp != NULL ) {
+    fclose( fp );
+  }
+  fp = fopen( results_file, "a" );
+  if( fp == NULL ) {
+    perror( results_file );
+    exit(1);
+  }
+  if( ftell( fp ) == 0 ) {
+    fputs( header, fp );
+    fflush( fp );
+  }
+  printf("%s", header );
+
+  // The test stops once the log-likelihood ratio leaves the range that
+  // gives errors of 5% each way.
+  lower = log( 0.05 / 0.95 );
+  upper = log( 0.95 / 0.05 );
+
+  signal( SIGPIPE, SIG_IGN );
+  for( k = 0; k < num_workers; k++ ) {
+    if( !start_worker( &workers[k] )) {
+      perror( "fork" );
+      exit(1);
+    }
+  }
+
+  while( TRUE ) {
+    int n = wins + draws + losses;
+    double ratio = sprt && n > 0 ? llr( elo0, elo1 ) : 0.0;
+    int decided = ( ratio <= lower || ratio >= upper );
+
+    // give every idle worker the next game that has not been played
+    for( k = 0; k < num_workers && !decided; k++ ) {
+      if( !workers[k].busy ) {
+        while( next_game < num_games && played[next_game] ) {
+          next_game++;
+        }
+        if( next_game < num_games ) {
+          fprintf( workers[k].in, "%d\n", next_game++ );
+          fflush( workers[k].in );
+          workers[k].busy = TRUE;
+          running++;
+        }
+      }
+    }
+    if( running == 0 ) {
+      break;
+    }
+
+    // wait for any of them to finish a game
+    fd_set fds;
+    int max_fd = 0;
+    FD_ZERO( &fds );
+    for( k = 0; k < num_workers; k++ ) {
+      if( workers[k].busy ) {
+        FD_SET( fileno( workers[k].out ), &fds );
+        if( fileno( workers[k].out ) > max_fd ) {
+          max_fd = fileno( workers[k].out );
+        }
+      }
+    }
+    if( select( max_fd + 1, &fds, NULL, NULL, NULL ) < 0 ) {
+      perror( "select" );
+      break;
+    }
+    for( k = 0; k < num_workers; k++ ) {
+      if( workers[k].busy && FD_ISSET( fileno( workers[k].out ), &fds )) {
+        workers[k].busy = FALSE;
+        running--;
+        if( fgets( line, sizeof( line ), workers[k].out ) == NULL
+           || !count_result( line, num_games )) {
+          fprintf( stderr, "worker %d stopped\n", k );
+          exit(1);
+        }
+        fputs( line, fp );
+        fflush( fp );
+        n = wins + draws + losses;
+        if( n % 10 == 0 ) {
+          print_standings( stdout, sprt, elo0, elo1 );
+        }
+      }
+    }
+  }
+
+  for( k = 0; k < num_workers; k++ ) {
+    fclose( workers[k].in );
+    fclose( workers[k].out );
+    waitpid( workers[k].pid, NULL, 0 );
+  }
+  fclose( fp );
+
+  print_standings( stdout, sprt, elo0, elo1 );
+  if( sprt ) {
+    double ratio = llr( elo0, elo1 );
+    printf("SPRT elo0 %.1f elo1 %.1f  %s\n", elo0, elo1,
+           ratio >= upper ? "H1 accepted, A is stronger"
+           : ratio <= lower ? "H0 accepted, A is not stronger"
+           : "no decision" );
+  }
+  free( openings );
+  return 0;
+}
@@ -0,0 +1,172 @@
+/*********************************************************
+ *  ttable.c
+ *  Nine-Board Tic-Tac-Toe Transposition Table
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ *
+ *  The table is an array of buckets holding two entries each.
+ *  The first entry of a bucket keeps the deepest result seen,
+ *  unless it is left over from an earlier search, and the second
+ *  is always replaced, so that recent shallow results still get
+ *  stored without pushing out the expensive deep ones.
+ *
+ *  Each engine has a table of its own, which is shared by all its
+ *  search threads without any locking.
+ *  Each entry is two 64-bit words, the packed data and the key
+ *  XORed with that data, each read and written atomically. If two
+ *  threads write the same entry at once and the words end up from
+ *  different writes, the XOR no longer gives back the key, so the
+ *  torn entry simply looks like a miss.
+ */
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "common.h"
+#include "ttable.h"
+
+// layout of the packed data word
+#define SCORE_BITS     16
+#define DEPTH_SHIFT    16
+#define BOUND_SHIFT    24
+#define MOVE_SHIFT     26
+#define AGE_SHIFT      32
+
+typedef struct {
+  uint64_t check;  // key ^ data
+  uint64_t data;
+} tt_slot;
+
+typedef struct tt_bucket {
+  tt_slot deep;    // depth-preferred
+  tt_slot recent;  // always replaced
+} tt_bucket;
+
+/*********************************************************
+   Allocate the table, using at most the given number of megabytes
+*/
+void tt_init( tt_table *tt, int megabytes )
+{
+  uint64_t buckets = 1;
+
+  // the number of buckets is a power of two so a key can be masked to an index
+  while( buckets * 2 * sizeof( tt_bucket ) <= ( uint64_t )megabytes << 20 ) {
+    buckets *= 2;
+  }
+
+  tt_free( tt );
+  tt->buckets = malloc( buckets * sizeof( tt_bucket ));
+  if( tt->buckets == NULL ) {
+    perror("cannot allocate transposition table ");
+    exit(1);
+  }
+  tt->mask = buckets - 1;
+  tt_clear( tt );
+}
+
+/*********************************************************
+   Empty the table, at the start of each game
+*/
+void tt_clear( tt_table *tt )
+{
+  memset( tt->buckets, 0, ( tt->mask + 1 ) * sizeof( tt_bucket ));
+  tt->age = 0;
+}
+
+/*********************************************************
+   Mark the start of a new search
+*/
+void tt_new_search( tt_table *tt )
+{
+  tt->age++;
+}
+
+/*********************************************************
+   Pack an entry into one word
+*/
+uint64_t pack( int depth, int bound, int score, int move, int age )
+{
+  return(  ( uint64_t )( uint16_t )score
+         | ( uint64_t )( depth & 0xFF ) << DEPTH_SHIFT
+         | ( uint64_t )( bound & 0x3 )  << BOUND_SHIFT
+         | ( uint64_t )( move & 0xF )   << MOVE_SHIFT
+         | ( uint64_t )( age & 0xFF )   << AGE_SHIFT );
+}
+
+/*********************************************************
+   Unpack a word into an entry
+*/
+void unpack( uint64_t data, tt_entry *entry )
+{
+  entry->score = ( int16_t )( data & (( 1 << SCORE_BITS ) - 1 ));
+  entry->depth = ( data >> DEPTH_SHIFT ) & 0xFF;
+  entry->bound = ( data >> BOUND_SHIFT ) & 0x3;
+  entry->move  = ( data >> MOVE_SHIFT )  & 0xF;
+  entry->age   = ( data >> AGE_SHIFT )   & 0xFF;
+}
+
+/*********************************************************
+   Read a slot, returning TRUE if it holds the given key
+*/
+int read_slot( tt_slot *slot, uint64_t key, uint64_t *data )
+{
+  uint64_t check = __atomic_load_n( &slot->check, __ATOMIC_RELAXED );
+  *data = __atomic_load_n( &slot->data, __ATOMIC_RELAXED );
+  return(( check ^ *data ) == key && *data != 0 );
+}
+
+/*********************************************************
+   Look up a key, returning TRUE and filling in *entry if it is found
+*/
+int tt_probe( tt_table *tt, uint64_t key, tt_entry *entry )
+{
+  tt_bucket *b = &tt->buckets[key & tt->mask];
+  uint64_t data;
+
+  if(   read_slot( &b->deep,   key, &data )
+     || read_slot( &b->recent, key, &data )) {
+    unpack( data, entry );
+    return( entry->bound != BOUND_NONE );
+  }
+  return( FALSE );
+}
+
+/*********************************************************
+   Store the result of a search
+*/
+void tt_store( tt_table *tt, uint64_t key, int depth, int bound, int score, int move )
+{
+  tt_bucket *b = &tt->buckets[key & tt->mask];
+  tt_slot   *slot;
+  tt_entry   old;
+  uint64_t   data;
+
+  // the depth and age of what is in the first slot decide which one is replaced
+  unpack( __atomic_load_n( &b->deep.data, __ATOMIC_RELAXED ), &old );
+  if( old.age != tt->age || depth >= old.depth ) {
+    slot = &b->deep;
+  }
+  else {
+    slot = &b->recent;
+  }
+
+  // keep the best move of an earlier search of the same position
+  // if this one did not find one
+  if( move == 0 && read_slot( slot, key, &data )) {
+    unpack( data, &old );
+    move = old.move;
+  }
+
+  data = pack( depth, bound, score, move, tt->age );
+  __atomic_store_n( &slot->check, key ^ data, __ATOMIC_RELAXED );
+  __atomic_store_n( &slot->data, data, __ATOMIC_RELAXED );
+}
+
+/*********************************************************
+   Release the table
+*/
+void tt_free( tt_table *tt )
+{
+  free( tt->buckets );
+  tt->buckets = NULL;
+}
@@ -0,0 +1,51 @@
+/*********************************************************
+ *  ttable.h
+ *  Nine-Board Tic-Tac-Toe Transposition Table
+ *  COMP3411/9414/9814 Artificial Intelligence
+ *  Dion Earle, Assignment 3
+ */
+#ifndef TTABLE_H
+#define TTABLE_H
+
+#include <stdint.h>
+
+// how a stored score relates to the true value of the position
+#define BOUND_NONE     0
+#define BOUND_UPPER    1  // search failed low, true value <= score
+#define BOUND_LOWER    2  // search failed high, true value >= score
+#define BOUND_EXACT    3
+
+typedef struct {
+  int score;
+  int depth;  // remaining depth the score was searched to
+  int bound;
+  int move;   // best move found, or 0
+  int age;    // search the entry was written in
+} tt_entry;
+
+// The table of one engine, shared by its search threads
+typedef struct {
+  struct tt_bucket *buckets;
+  uint64_t mask;   // number of buckets - 1
+  uint8_t  age;    // count of searches, so older entries are replaced first
+} tt_table;
+
+// Allocate the table, using at most the given number of megabytes
+void tt_init( tt_table *tt, int megabytes );
+
+// Empty the table, at the start of each game
+void tt_clear( tt_table *tt );
+
+// Mark the start of a new search, so entries from older ones are replaced first
+void tt_new_search( tt_table *tt );
+
+// Look up a key, returning TRUE and filling in *entry if it is found
+int tt_probe( tt_table *tt, uint64_t key, tt_entry *entry );
+
+// Store the result of a search
+void tt_store( tt_table *tt, uint64_t key, int depth, int bound, int score, int move );
+
+// Release the table
+void tt_free( tt_table *tt );
+
+#endif